@@ -7,6 +7,14 @@ import matplotlib.pyplot as plt
 
 RESULTS_FILE = "results.csv"
 
+# --latency columns: <outcome>_<pct>_ns ("lat" = all operations).
+LATENCY_OUTCOMES = ["lat", "hot", "cold", "miss", "promote"]
+LATENCY_PCTS = ["p50", "p99", "p999"]
+
+# --ycsb columns: <op>_<metric> per operation type.
+YCSB_OPS = ["read", "update", "insert", "scan", "rmw"]
+YCSB_METRICS = ["ops", "qps", "nodes"]
+
 def load_results(path=RESULTS_FILE):
     rows = []
     with open(path, newline="") as f:
@@ -19,8 +27,16 @@ def load_results(path=RESULTS_FILE):
                 "elapsed_sec", "qps",
                 "hot_hits", "cold_hits", "not_found",
                 "hot_keys", "cold_keys",
-                "avg_hot_nodes_per_q", "avg_cold_nodes_per_q"
-            ]:
+                "avg_hot_nodes_per_q", "avg_cold_nodes_per_q",
+                "ns_per_node_visit", "build_sec", "deletes",
+                "promotions", "demotions", "hot_hit_ratio_after_shift",
+                "heat_bytes", "batch",
+                "not_found_filtered", "filter_bytes",
+                "async_promote", "promote_dropped", "hot_bypassed",
+                "shards", "threads", "qps_thread_min", "qps_thread_max",
+                "olc_restarts", "scaling_eff", "pregen"
+            ] + [f"{o}_{p}_ns" for o in LATENCY_OUTCOMES for p in LATENCY_PCTS] \
+              + [f"{o}_{m}" for o in YCSB_OPS for m in YCSB_METRICS]:
                 if k in r and r[k] != "":
                     r[k] = float(r[k])
             rows.append(r)
@@ -33,6 +49,8 @@ def group_key(row):
 def summarize(rows):
     grouped = defaultdict(dict)
     for r in rows:
+        if r.get("ycsb", "none") != "none":
+            continue   # mixed workloads: see print_ycsb_table
         gk = group_key(r)
         grouped[gk][r["mode"]] = r
     return grouped
@@ -60,6 +78,45 @@ def print_comparison_table(grouped):
               f"{nodes_base:.3f},{nodes_hc:.3f},"
               f"{hot_frac:.4f},{hot_hits_frac:.4f}")
 
+def print_scaling_table(rows):
+    """--threads runs: aggregate QPS, per-thread spread, efficiency vs solo."""
+    threaded = [r for r in rows if r.get("threads", 1) > 1]
+    if not threaded:
+        return
+    print("\n=== Thread scaling ===")
+    print("mode,workload,theta,threads,qps,qps_thread_min,qps_thread_max,"
+          "scaling_eff,olc_restarts_per_op")
+    for r in sorted(threaded, key=lambda r: (r["mode"], r["workload"], r["theta"], r["threads"])):
+        restarts = r["olc_restarts"] / r["nqueries"] if r["nqueries"] > 0 else 0.0
+        print(f"{r['mode']},{r['workload']},{r['theta']:.3f},{int(r['threads'])},"
+              f"{r['qps']:.1f},{r['qps_thread_min']:.1f},{r['qps_thread_max']:.1f},"
+              f"{r['scaling_eff']:.3f},{restarts:.6f}")
+
+def print_latency_table(rows):
+    """--latency runs: p50 / p99 / p99.9 in ns, overall and per outcome."""
+    timed = [r for r in rows if r.get("lat_p50_ns", 0) > 0]
+    if not timed:
+        return
+    print("\n=== Latency percentiles (ns) ===")
+    print("mode,workload,theta,threads," +
+          ",".join(f"{o}_{p}" for o in LATENCY_OUTCOMES for p in LATENCY_PCTS))
+    for r in timed:
+        vals = ",".join(f"{int(r[f'{o}_{p}_ns'])}" for o in LATENCY_OUTCOMES for p in LATENCY_PCTS)
+        print(f"{r['mode']},{r['workload']},{r['theta']:.3f},{int(r.get('threads', 1))},{vals}")
+
+def print_ycsb_table(rows):
+    """--ycsb runs: ops, Q/s and nodes/op per operation type."""
+    mixed = [r for r in rows if r.get("ycsb", "none") != "none"]
+    if not mixed:
+        return
+    print("\n=== YCSB workloads ===")
+    print("ycsb,dist,mode,shards,op,ops,qps,nodes_per_op")
+    for r in mixed:
+        for o in YCSB_OPS:
+            if r[f"{o}_ops"] > 0:
+                print(f"{r['ycsb']},{r['ycsb_dist']},{r['mode']},{int(r.get('shards', 1))},{o},"
+                      f"{int(r[f'{o}_ops'])},{r[f'{o}_qps']:.2f},{r[f'{o}_nodes']:.3f}")
+
 def plot_qps_vs_mode(grouped):
     # One panel per (workload, theta)
     fig, ax = plt.subplots()
@@ -164,6 +221,9 @@ def main():
     rows = load_results()
     grouped = summarize(rows)
     print_comparison_table(grouped)
+    print_scaling_table(rows)
+    print_latency_table(rows)
+    print_ycsb_table(rows)
     plot_qps_vs_mode(grouped)
     plot_nodes_vs_mode(grouped)
     plot_hot_fraction_vs_theta(grouped)
@@ -0,0 +1,73 @@
+// bloom.c
+#include "bloom.h"
+#include "hash64.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define BLOOM_BLOCK      64                 // bytes per block
+#define BLOOM_BLOCK_BITS (BLOOM_BLOCK * 8)
+#define BLOOM_MAX_PROBES 16
+
+struct BloomFilter {
+    uint64_t *bits;      // nblocks * BLOOM_BLOCK bytes, 64-byte aligned
+    size_t    nblocks;   // power of two
+    size_t    capacity;
+    int       probes;
+};
+
+BloomFilter* bloom_create(size_t capacity, double bits_per_key) {
+    BloomFilter *f = (BloomFilter*)malloc(sizeof(BloomFilter));
+    size_t want = (size_t)((double)capacity * bits_per_key / BLOOM_BLOCK_BITS) + 1;
+    size_t nblocks = 1;
+    while (nblocks < want) nblocks *= 2;
+    f->nblocks = nblocks;
+    f->bits = (uint64_t*)aligned_alloc(BLOOM_BLOCK, nblocks * BLOOM_BLOCK);
+    memset(f->bits, 0, nblocks * BLOOM_BLOCK);
+    f->capacity = capacity;
+
+    // k = ln 2 * bits per key minimizes the false-positive rate.
+    int k = (int)(bits_per_key * 0.69 + 0.5);
+    f->probes = k < 1 ? 1 : k > BLOOM_MAX_PROBES ? BLOOM_MAX_PROBES : k;
+    return f;
+}
+
+void bloom_free(BloomFilter *f) {
+    if (!f) return;
+    free(f->bits);
+    free(f);
+}
+
+// Low bits pick the block; the high 32 bits seed double hashing for the
+// probe positions inside it.
+static uint64_t* bloom_block(const BloomFilter *f, uint64_t h) {
+    return f->bits + (h & (f->nblocks - 1)) * (BLOOM_BLOCK / sizeof(uint64_t));
+}
+
+void bloom_add(BloomFilter *f, uint64_t key) {
+    uint64_t h = mix64(key);
+    uint64_t *b = bloom_block(f, h);
+    uint32_t h1 = (uint32_t)(h >> 32), h2 = (uint32_t)(h >> 48) | 1;
+    for (int i = 0; i < f->probes; i++) {
+        uint32_t bit = (h1 + (uint32_t)i * h2) & (BLOOM_BLOCK_BITS - 1);
+        b[bit / 64] |= 1ULL << (bit % 64);
+    }
+}
+
+int bloom_may_contain(const BloomFilter *f, uint64_t key) {
+    uint64_t h = mix64(key);
+    const uint64_t *b = bloom_block(f, h);
+    uint32_t h1 = (uint32_t)(h >> 32), h2 = (uint32_t)(h >> 48) | 1;
+    for (int i = 0; i < f->probes; i++) {
+        uint32_t bit = (h1 + (uint32_t)i * h2) & (BLOOM_BLOCK_BITS - 1);
+        if (!(b[bit / 64] & (1ULL << (bit % 64)))) return 0;
+    }
+    return 1;
+}
+
+size_t bloom_capacity(const BloomFilter *f) {
+    return f->capacity;
+}
+
+size_t bloom_bytes(const BloomFilter *f) {
+    return f->nblocks * BLOOM_BLOCK;
+}
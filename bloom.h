@@ -0,0 +1,32 @@
+// bloom.h
+#ifndef BLOOM_H
+#define BLOOM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Blocked Bloom filter: every key maps to one 64-byte block and sets all of
+// its probe bits there, so a membership test costs a single cache line.
+// No deletes: a removed key only leaves its bits behind, which can raise
+// the false-positive rate but never causes a false negative.
+
+typedef struct BloomFilter BloomFilter;
+
+// Size for `capacity` keys at bits_per_key bits each (rounded up to a
+// power-of-two number of blocks); the probe count follows from
+// bits_per_key.
+BloomFilter* bloom_create(size_t capacity, double bits_per_key);
+void         bloom_free(BloomFilter *f);
+
+void         bloom_add(BloomFilter *f, uint64_t key);
+
+// 0 if key was never added; 1 if it may have been.
+int          bloom_may_contain(const BloomFilter *f, uint64_t key);
+
+// Number of keys the filter was sized for.
+size_t       bloom_capacity(const BloomFilter *f);
+
+// Memory used by the bit array, in bytes.
+size_t       bloom_bytes(const BloomFilter *f);
+
+#endif // BLOOM_H
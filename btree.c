@@ -4,77 +4,587 @@
 #include <string.h>
 #include <stdio.h>
 #include <assert.h>
+#include <stdatomic.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BT_HAVE_X86_KERNELS 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define BT_HAVE_NEON_KERNEL 1
+#endif
 
 struct BTreeNode {
+    _Atomic uint64_t version;   // concurrent trees: odd while write-locked
     int       nkeys;
     BTKey    *keys;
-    BTPayload *values;
-    BTreeNode **children;
+    BTPayload *values;      // NULL in B+tree internal nodes
+    BTreeNode **children;   // NULL in B+tree leaves
     int       leaf;
+    BTreeNode *prev, *next; // B+tree leaf chain
 };
 
-static BTreeNode* bt_new_node(int t, int leaf) {
+// Concurrency state of a tree (bt_make_concurrent).
+struct BTSync {
+    atomic_flag      latch;         // writer latch
+    _Atomic uint64_t root_version;
+    int              root_locked;
+    BTreeNode      **locked;        // nodes locked by the current writer
+    size_t           nlocked, locked_cap;
+    BTreeNode      **retired;       // unlinked nodes, freed by bt_free
+    size_t           nretired, retired_cap;
+    _Atomic long     restarts;      // optimistic descents that failed
+};
+
+// B+tree engine (BT_VARIANT_BPLUS), at the end of this file. The public
+// functions dispatch to it on tree->variant.
+static BTPayload bp_search(BTree *tree, BTKey k, BTStats *stats);
+static BTPayload bp_search_path(BTree *tree, BTKey k, BTPath *path, BTStats *stats);
+static void      bp_insert(BTree *tree, BTKey k, BTPayload v);
+static int       bp_delete(BTree *tree, BTKey k);
+static void      bp_bulk_load(BTree *tree, const BTKey *keys, const BTPayload *values,
+                              size_t n, double fill_factor);
+static void      bp_range_search(BTree *tree, BTKey lo, BTKey hi,
+                                 BTRangeCallback cb, void *arg, BTStats *stats);
+static void      bp_iter_seek(BTPath *it, BTree *tree, BTKey k, BTStats *stats);
+static void      bp_iter_last(BTPath *it, BTree *tree, BTStats *stats);
+static void      bp_iter_next(BTPath *it, BTStats *stats);
+static void      bp_iter_prev(BTPath *it, BTStats *stats);
+
+#ifdef BT_PACKED_NODES
+// Packed layout: header, keys, children and values share one allocation
+// aligned to BT_NODE_ALIGN. Children follow keys because a descent reads
+// keys[] and then children[i]; values are only touched on a hit.
+#ifndef BT_NODE_ALIGN
+#define BT_NODE_ALIGN 64
+#endif
+
+static size_t bt_align_up(size_t n, size_t a) {
+    return (n + a - 1) / a * a;
+}
+
+// Node with room for cap keys, cap payloads if with_values, and nchild
+// child pointers (absent arrays are NULL).
+static BTreeNode* bt_alloc_node(int cap, int with_values, int nchild, int leaf) {
+    size_t hdr   = bt_align_up(sizeof(BTreeNode), sizeof(BTKey));
+    size_t total = hdr
+                 + sizeof(BTKey) * cap
+                 + sizeof(BTreeNode*) * nchild
+                 + (with_values ? sizeof(BTPayload) * cap : 0);
+    char *mem = (char*)aligned_alloc(BT_NODE_ALIGN, bt_align_up(total, BT_NODE_ALIGN));
+    BTreeNode *node = (BTreeNode*)mem;
+    atomic_init(&node->version, 0);
+    node->nkeys = 0;
+    node->leaf = leaf;
+    node->prev = node->next = NULL;
+    node->keys = (BTKey*)(mem + hdr);
+    node->children = nchild ? (BTreeNode**)(node->keys + cap) : NULL;
+    node->values = with_values ? (BTPayload*)((BTreeNode**)(node->keys + cap) + nchild) : NULL;
+    for (int i = 0; i < nchild; i++) node->children[i] = NULL;
+    return node;
+}
+
+static void bt_release_node(BTreeNode *node) {
+    free(node);
+}
+#else
+static BTreeNode* bt_alloc_node(int cap, int with_values, int nchild, int leaf) {
     BTreeNode *node = (BTreeNode*)malloc(sizeof(BTreeNode));
+    atomic_init(&node->version, 0);
     node->nkeys = 0;
     node->leaf = leaf;
-    node->keys = (BTKey*)malloc(sizeof(BTKey) * (2*t - 1));
-    node->values = (BTPayload*)malloc(sizeof(BTPayload) * (2*t - 1));
-    node->children = (BTreeNode**)malloc(sizeof(BTreeNode*) * (2*t));
-    for (int i = 0; i < 2*t; i++) node->children[i] = NULL;
+    node->prev = node->next = NULL;
+    node->keys = (BTKey*)malloc(sizeof(BTKey) * cap);
+    node->values = with_values ? (BTPayload*)malloc(sizeof(BTPayload) * cap) : NULL;
+    node->children = nchild ? (BTreeNode**)malloc(sizeof(BTreeNode*) * nchild) : NULL;
+    for (int i = 0; i < nchild; i++) node->children[i] = NULL;
     return node;
 }
 
-static void bt_free_node(BTreeNode *node, int t) {
-    if (!node) return;
-    if (!node->leaf) {
-        for (int i = 0; i <= node->nkeys; i++)
-            bt_free_node(node->children[i], t);
-    }
+static void bt_release_node(BTreeNode *node) {
     free(node->keys);
     free(node->values);
     free(node->children);
     free(node);
 }
+#endif
 
-BTree* bt_create(int t) {
+// Classic B-tree node: 2t-1 keys and payloads, 2t children.
+static BTreeNode* bt_new_node(int t, int leaf) {
+    return bt_alloc_node(2*t - 1, 1, 2*t, leaf);
+}
+
+const char* bt_node_layout(void) {
+#ifdef BT_PACKED_NODES
+    return "packed";
+#else
+    return "split";
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// In-node search kernels. Each returns the lower bound of k in keys[0..n),
+// i.e. the first slot i with keys[i] >= k (n if there is none). Keys within
+// a node are sorted, so "number of keys < k" is the same thing, which is
+// what the SIMD kernels count.
+
+typedef int (*BTLowerBoundFn)(const BTKey *keys, int n, BTKey k);
+
+static int bt_lb_scalar(const BTKey *keys, int n, BTKey k) {
+    int i = 0;
+    while (i < n && k > keys[i]) i++;
+    return i;
+}
+
+// Branchless binary search: the loop trip count depends only on n and the
+// compare compiles to a conditional move.
+static int bt_lb_binary(const BTKey *keys, int n, BTKey k) {
+    if (n == 0) return 0;
+    const BTKey *base = keys;
+    while (n > 1) {
+        int half = n / 2;
+        base = (base[half] < k) ? base + half : base;
+        n -= half;
+    }
+    return (int)(base - keys) + (*base < k);
+}
+
+#ifdef BT_HAVE_X86_KERNELS
+// The SIMD kernels count every key < k without an early exit: for
+// node-sized arrays the extra compares are cheaper than a mispredicted
+// loop exit. cmpgt yields -1 per matching lane, so subtracting accumulates.
+__attribute__((target("sse4.2")))
+static int bt_lb_sse42(const BTKey *keys, int n, BTKey k) {
+    __m128i kv = _mm_set1_epi64x(k);
+    __m128i acc = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(keys + i));
+        acc = _mm_sub_epi64(acc, _mm_cmpgt_epi64(kv, v));
+    }
+    int cnt = (int)(_mm_cvtsi128_si64(acc) + _mm_extract_epi64(acc, 1));
+    for (; i < n; i++) cnt += keys[i] < k;
+    return cnt;
+}
+
+__attribute__((target("avx2")))
+static int bt_lb_avx2(const BTKey *keys, int n, BTKey k) {
+    __m256i kv = _mm256_set1_epi64x(k);
+    __m256i acc = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(keys + i));
+        acc = _mm256_sub_epi64(acc, _mm256_cmpgt_epi64(kv, a));
+    }
+    __m128i s2 = _mm_add_epi64(_mm256_castsi256_si128(acc),
+                               _mm256_extracti128_si256(acc, 1));
+    int cnt = (int)(_mm_cvtsi128_si64(s2) + _mm_extract_epi64(s2, 1));
+    for (; i < n; i++) cnt += keys[i] < k;
+    return cnt;
+}
+#endif
+
+#ifdef BT_HAVE_NEON_KERNEL
+static int bt_lb_neon(const BTKey *keys, int n, BTKey k) {
+    int64x2_t kv = vdupq_n_s64(k);
+    int64x2_t acc = vdupq_n_s64(0);
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        uint64x2_t lt = vcgtq_s64(kv, vld1q_s64(keys + i));
+        acc = vsubq_s64(acc, vreinterpretq_s64_u64(lt));
+    }
+    int cnt = (int)vaddvq_s64(acc);
+    for (; i < n; i++) cnt += keys[i] < k;
+    return cnt;
+}
+#endif
+
+static BTLowerBoundFn bt_lower_bound = bt_lb_scalar;
+static BTSearchKernel bt_kernel      = BT_SEARCH_SCALAR;
+static int            bt_kernel_init = 0;
+
+static int bt_kernel_supported(BTSearchKernel kind) {
+    switch (kind) {
+    case BT_SEARCH_SCALAR:
+    case BT_SEARCH_BINARY:
+        return 1;
+#ifdef BT_HAVE_X86_KERNELS
+    case BT_SEARCH_SSE42:
+        return __builtin_cpu_supports("sse4.2");
+    case BT_SEARCH_AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+#ifdef BT_HAVE_NEON_KERNEL
+    case BT_SEARCH_NEON:
+        return 1;
+#endif
+    default:
+        return 0;
+    }
+}
+
+int bt_set_search_kernel(BTSearchKernel kind) {
+    if (kind == BT_SEARCH_AUTO) {
+        if (bt_kernel_supported(BT_SEARCH_AVX2))       kind = BT_SEARCH_AVX2;
+        else if (bt_kernel_supported(BT_SEARCH_SSE42)) kind = BT_SEARCH_SSE42;
+        else if (bt_kernel_supported(BT_SEARCH_NEON))  kind = BT_SEARCH_NEON;
+        else                                           kind = BT_SEARCH_SCALAR;
+    }
+    if (!bt_kernel_supported(kind)) return 0;
+
+    switch (kind) {
+    case BT_SEARCH_BINARY: bt_lower_bound = bt_lb_binary; break;
+#ifdef BT_HAVE_X86_KERNELS
+    case BT_SEARCH_SSE42:  bt_lower_bound = bt_lb_sse42;  break;
+    case BT_SEARCH_AVX2:   bt_lower_bound = bt_lb_avx2;   break;
+#endif
+#ifdef BT_HAVE_NEON_KERNEL
+    case BT_SEARCH_NEON:   bt_lower_bound = bt_lb_neon;   break;
+#endif
+    default:               bt_lower_bound = bt_lb_scalar; break;
+    }
+    bt_kernel = kind;
+    bt_kernel_init = 1;
+    return 1;
+}
+
+BTSearchKernel bt_get_search_kernel(void) {
+    return bt_kernel;
+}
+
+int bt_search_kernel_available(BTSearchKernel kind) {
+    return kind == BT_SEARCH_AUTO || bt_kernel_supported(kind);
+}
+
+const char* bt_search_kernel_name(BTSearchKernel kind) {
+    switch (kind) {
+    case BT_SEARCH_AUTO:   return "auto";
+    case BT_SEARCH_SCALAR: return "scalar";
+    case BT_SEARCH_BINARY: return "binary";
+    case BT_SEARCH_SSE42:  return "sse4.2";
+    case BT_SEARCH_AVX2:   return "avx2";
+    case BT_SEARCH_NEON:   return "neon";
+    }
+    return "unknown";
+}
+
+static BTreeNode* bp_new_leaf(int t);
+
+// Only the writer changes tree->nkeys, but with a concurrent tree any
+// thread may read it (bt_count_keys), so both sides use relaxed atomics.
+static void bt_count_set(BTree *tree, size_t n) {
+    atomic_store_explicit(&tree->nkeys, n, memory_order_relaxed);
+}
+
+static void bt_count_add(BTree *tree, long d) {
+    bt_count_set(tree, atomic_load_explicit(&tree->nkeys, memory_order_relaxed) + (size_t)d);
+}
+
+BTree* bt_create_variant(int t, BTVariant variant) {
     BTree *tree = (BTree*)malloc(sizeof(BTree));
+    if (!bt_kernel_init) bt_set_search_kernel(BT_SEARCH_AUTO);
     tree->t = t;
-    tree->root = bt_new_node(t, 1);
+    atomic_init(&tree->nkeys, 0);
+    tree->variant = variant;
+    tree->sync = NULL;
+    tree->root = variant == BT_VARIANT_BPLUS ? bp_new_leaf(t) : bt_new_node(t, 1);
     return tree;
 }
 
+BTree* bt_create(int t) {
+    return bt_create_variant(t, BT_VARIANT_BTREE);
+}
+
+const char* bt_variant_name(BTVariant variant) {
+    switch (variant) {
+    case BT_VARIANT_BTREE: return "btree";
+    case BT_VARIANT_BPLUS: return "bplus";
+    }
+    return "unknown";
+}
+
+// Post-order free with an explicit stack: slot[d] is the next child of
+// node[d] to visit.
 void bt_free(BTree *tree) {
     if (!tree) return;
-    bt_free_node(tree->root, tree->t);
+    if (tree->root) {
+        BTPath st;
+        st.depth = 1;
+        st.node[0] = tree->root;
+        st.slot[0] = 0;
+        while (st.depth > 0) {
+            int d = st.depth - 1;
+            BTreeNode *x = st.node[d];
+            if (!x->leaf && st.slot[d] <= x->nkeys) {
+                st.node[d+1] = x->children[st.slot[d]++];
+                st.slot[d+1] = 0;
+                st.depth++;
+            } else {
+                bt_release_node(x);
+                st.depth--;
+            }
+        }
+    }
+    if (tree->sync) {
+        for (size_t i = 0; i < tree->sync->nretired; i++)
+            bt_release_node(tree->sync->retired[i]);
+        free(tree->sync->retired);
+        free(tree->sync->locked);
+        free(tree->sync);
+    }
     free(tree);
 }
 
-static BTPayload bt_search_node(BTreeNode *node, BTKey k, BTStats *stats, int t) {
-    if (stats) stats->node_visits++;
+// ---------------------------------------------------------------------------
+// Optimistic lock coupling (bt_make_concurrent). A node's version is even
+// while it is unlocked and odd while a writer holds it. A reader notes the
+// version of each node before reading it and checks it again afterwards
+// (when descending, after noting the child's version, so a split or merge
+// of the child in between is caught too), and starts over from the root
+// if it changed. root_version does the same for tree->root. A writer
+// holds the tree latch for its whole operation, locks each node before
+// first modifying it, and unlocks them all, with new versions, at the end.
 
-    int i = 0;
-    while (i < node->nkeys && k > node->keys[i]) i++;
+static void bt_cpu_relax(void) {
+#ifdef BT_HAVE_X86_KERNELS
+    _mm_pause();
+#endif
+}
 
-    if (i < node->nkeys && k == node->keys[i]) {
-        return node->values[i];
+static void bt_node_push(BTreeNode ***arr, size_t *n, size_t *cap, BTreeNode *x) {
+    if (*n == *cap) {
+        *cap = *cap ? 2 * *cap : 16;
+        *arr = (BTreeNode**)realloc(*arr, sizeof(BTreeNode*) * *cap);
     }
+    (*arr)[(*n)++] = x;
+}
 
-    if (node->leaf) {
-        return NULL;
-    } else {
-        return bt_search_node(node->children[i], k, stats, t);
+void bt_make_concurrent(BTree *tree) {
+    if (tree->sync) return;
+    BTSync *s = (BTSync*)calloc(1, sizeof(BTSync));
+    atomic_flag_clear(&s->latch);
+    atomic_init(&s->root_version, 0);
+    atomic_init(&s->restarts, 0);
+    tree->sync = s;
+}
+
+long bt_olc_restarts(const BTree *tree) {
+    if (!tree || !tree->sync) return 0;
+    return atomic_load_explicit(&tree->sync->restarts, memory_order_relaxed);
+}
+
+// Make a version odd (locked); the fence keeps the writes that follow
+// from becoming visible before it.
+static void bt_version_lock(_Atomic uint64_t *v) {
+    atomic_store_explicit(v, atomic_load_explicit(v, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+// Make a locked version even again, publishing the writes made under it.
+static void bt_version_unlock(_Atomic uint64_t *v) {
+    atomic_store_explicit(v, atomic_load_explicit(v, memory_order_relaxed) + 1,
+                          memory_order_release);
+}
+
+static void bt_write_begin(BTree *tree) {
+    BTSync *s = tree->sync;
+    if (!s) return;
+    while (atomic_flag_test_and_set_explicit(&s->latch, memory_order_acquire))
+        bt_cpu_relax();
+}
+
+static void bt_write_end(BTree *tree) {
+    BTSync *s = tree->sync;
+    if (!s) return;
+    for (size_t i = 0; i < s->nlocked; i++) bt_version_unlock(&s->locked[i]->version);
+    s->nlocked = 0;
+    if (s->root_locked) {
+        bt_version_unlock(&s->root_version);
+        s->root_locked = 0;
+    }
+    atomic_flag_clear_explicit(&s->latch, memory_order_release);
+}
+
+// Lock x for the current writer before its first modification.
+static void bt_wlock(BTree *tree, BTreeNode *x) {
+    BTSync *s = tree->sync;
+    if (!s || !x || (atomic_load_explicit(&x->version, memory_order_relaxed) & 1)) return;
+    bt_version_lock(&x->version);
+    bt_node_push(&s->locked, &s->nlocked, &s->locked_cap, x);
+}
+
+// Lock tree->root itself before replacing it.
+static void bt_wlock_root(BTree *tree) {
+    BTSync *s = tree->sync;
+    if (!s || s->root_locked) return;
+    bt_version_lock(&s->root_version);
+    s->root_locked = 1;
+}
+
+// Free a node that is no longer reachable, or keep it until bt_free if a
+// reader may still be inside it. Its version changes, so such a reader
+// restarts.
+static void bt_retire(BTree *tree, BTreeNode *x) {
+    BTSync *s = tree->sync;
+    if (!s) {
+        bt_release_node(x);
+        return;
+    }
+    bt_wlock(tree, x);
+    bt_node_push(&s->retired, &s->nretired, &s->retired_cap, x);
+}
+
+// One optimistic descent. Returns 0 if a version check failed and the
+// search has to restart; otherwise stores the result in *out.
+static int bt_olc_try(BTree *tree, BTKey k, BTPayload *out, long *visits) {
+    BTSync *s = tree->sync;
+    int bplus = tree->variant == BT_VARIANT_BPLUS;
+
+    uint64_t rv = atomic_load_explicit(&s->root_version, memory_order_acquire);
+    if (rv & 1) return 0;
+    BTreeNode *x = tree->root;
+    uint64_t v = atomic_load_explicit(&x->version, memory_order_acquire);
+    atomic_thread_fence(memory_order_acquire);
+    if ((v & 1) || atomic_load_explicit(&s->root_version, memory_order_relaxed) != rv)
+        return 0;
+
+    for (;;) {
+        (*visits)++;
+        int n = x->nkeys;
+        int i = bt_lower_bound(x->keys, n, k);
+        int hit = i < n && x->keys[i] == k;
+        if (x->leaf || (hit && !bplus)) {
+            BTPayload r = hit ? x->values[i] : NULL;
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&x->version, memory_order_relaxed) != v) return 0;
+            *out = r;
+            return 1;
+        }
+        BTreeNode *c = x->children[i + (bplus && hit)];
+        if (!c) return 0;
+        uint64_t cv = atomic_load_explicit(&c->version, memory_order_acquire);
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&x->version, memory_order_relaxed) != v || (cv & 1))
+            return 0;
+        x = c;
+        v = cv;
+    }
+}
+
+static BTPayload bt_search_olc(BTree *tree, BTKey k, BTStats *stats) {
+    BTPayload v = NULL;
+    long visits = 0;
+    while (!bt_olc_try(tree, k, &v, &visits)) {
+        atomic_fetch_add_explicit(&tree->sync->restarts, 1, memory_order_relaxed);
+        bt_cpu_relax();
+    }
+    if (stats) stats->node_visits += visits;
+    return v;
+}
+
+BTPayload bt_search_path(BTree *tree, BTKey k, BTPath *path, BTStats *stats) {
+    path->depth = 0;
+    path->found = 0;
+    if (!tree || !tree->root) return NULL;
+    if (tree->variant == BT_VARIANT_BPLUS) return bp_search_path(tree, k, path, stats);
+
+    BTreeNode *x = tree->root;
+    for (;;) {
+        if (stats) stats->node_visits++;
+        int i = bt_lower_bound(x->keys, x->nkeys, k);
+        path->node[path->depth] = x;
+        path->slot[path->depth] = i;
+        path->depth++;
+
+        if (i < x->nkeys && k == x->keys[i]) {
+            path->found = 1;
+            return x->values[i];
+        }
+        if (x->leaf) return NULL;
+        x = x->children[i];
     }
 }
 
 BTPayload bt_search(BTree *tree, BTKey k, BTStats *stats) {
     if (!tree || !tree->root) return NULL;
-    return bt_search_node(tree->root, k, stats, tree->t);
+    if (tree->sync) return bt_search_olc(tree, k, stats);
+    if (tree->variant == BT_VARIANT_BPLUS) return bp_search(tree, k, stats);
+
+    BTreeNode *x = tree->root;
+    for (;;) {
+        if (stats) stats->node_visits++;
+        int i = bt_lower_bound(x->keys, x->nkeys, k);
+        if (i < x->nkeys && k == x->keys[i]) return x->values[i];
+        if (x->leaf) return NULL;
+        x = x->children[i];
+    }
+}
+
+// Prefetch the keys a search of x will read. x's header was prefetched a
+// round earlier, so reading keys and nkeys here is normally a cache hit.
+static inline void bt_prefetch_keys(const BTreeNode *x) {
+    const char *p = (const char*)x->keys;
+    const char *end = (const char*)(x->keys + x->nkeys);
+    for (; p < end; p += 64) __builtin_prefetch(p, 0, 3);
+}
+
+// Group-prefetched batch lookup. Each round first prefetches the key
+// arrays of all live lookups, then searches them and prefetches the node
+// headers of the next level.
+void bt_search_batch(BTree *tree, const BTKey *keys, size_t n,
+                     BTPayload *out, BTStats *stats) {
+    int bplus = tree->variant == BT_VARIANT_BPLUS;
+    long visits = 0;
+
+    if (tree->sync) {
+        for (size_t j = 0; j < n; j++) out[j] = bt_search_olc(tree, keys[j], stats);
+        return;
+    }
+
+    for (size_t base = 0; base < n; base += BT_BATCH_GROUP) {
+        int m = n - base < BT_BATCH_GROUP ? (int)(n - base) : BT_BATCH_GROUP;
+        BTreeNode *cur[BT_BATCH_GROUP];
+        int live[BT_BATCH_GROUP];
+        int nlive = m;
+        for (int j = 0; j < m; j++) {
+            cur[j] = tree->root;
+            live[j] = j;
+        }
+
+        while (nlive > 0) {
+            for (int a = 0; a < nlive; a++) bt_prefetch_keys(cur[live[a]]);
+
+            int still = 0;
+            for (int a = 0; a < nlive; a++) {
+                int j = live[a];
+                BTreeNode *x = cur[j];
+                BTKey k = keys[base + j];
+                int i = bt_lower_bound(x->keys, x->nkeys, k);
+                int hit = i < x->nkeys && x->keys[i] == k;
+                visits++;
+
+                if (x->leaf || (hit && !bplus)) {
+                    out[base + j] = hit ? x->values[i] : NULL;
+                    continue;
+                }
+                x = x->children[i + (bplus && hit)];
+                __builtin_prefetch(x, 0, 3);
+                cur[j] = x;
+                live[still++] = j;
+            }
+            nlive = still;
+        }
+    }
+    if (stats) stats->node_visits += visits;
 }
 
 // Split child y of node x at index i.
 static void bt_split_child(BTree *tree, BTreeNode *x, int i) {
     int t = tree->t;
     BTreeNode *y = x->children[i];
+    bt_wlock(tree, x);
+    bt_wlock(tree, y);
     BTreeNode *z = bt_new_node(t, y->leaf);
     z->nkeys = t - 1;
 
@@ -111,93 +621,927 @@ static void bt_split_child(BTree *tree, BTreeNode *x, int i) {
     x->nkeys++;
 }
 
-static void bt_insert_nonfull(BTree *tree, BTreeNode *x, BTKey k, BTPayload v) {
-    int i = x->nkeys - 1;
+// Top-down insert: every full child is split before descending into it,
+// so no node on the way down ever needs to be revisited.
+static void bt_insert_classic(BTree *tree, BTKey k, BTPayload v) {
+    BTreeNode *x = tree->root;
+    int t = tree->t;
+    if (x->nkeys == 2*t - 1) {
+        BTreeNode *s = bt_new_node(t, 0);
+        s->children[0] = x;
+        bt_wlock_root(tree);
+        tree->root = s;
+        bt_split_child(tree, s, 0);
+        x = s;
+    }
 
-    if (x->leaf) {
-        // Find position to insert
-        while (i >= 0 && k < x->keys[i]) {
-            x->keys[i+1] = x->keys[i];
-            x->values[i+1] = x->values[i];
-            i--;
+    for (;;) {
+        int i = bt_lower_bound(x->keys, x->nkeys, k);
+
+        // Overwrite if present (simple “update” semantics)
+        if (i < x->nkeys && x->keys[i] == k) {
+            bt_wlock(tree, x);
+            x->values[i] = v;
+            return;
         }
-        // Overwrite if equal (simple “update” semantics)
-        if (i >= 0 && x->keys[i] == k) {
+
+        if (x->leaf) {
+            bt_wlock(tree, x);
+            int n = x->nkeys - i;
+            memmove(&x->keys[i+1], &x->keys[i], sizeof(BTKey) * n);
+            memmove(&x->values[i+1], &x->values[i], sizeof(BTPayload) * n);
+            x->keys[i] = k;
             x->values[i] = v;
+            x->nkeys++;
+            bt_count_add(tree, 1);
             return;
         }
-        x->keys[i+1] = k;
-        x->values[i+1] = v;
-        x->nkeys++;
-    } else {
-        // Find child to descend
-        while (i >= 0 && k < x->keys[i]) i--;
-        i++;
-        if (x->children[i]->nkeys == 2*tree->t - 1) {
+
+        // Descend into child i, splitting it first if full
+        if (x->children[i]->nkeys == 2*t - 1) {
             bt_split_child(tree, x, i);
+            if (k == x->keys[i]) {
+                x->values[i] = v;
+                return;
+            }
             if (k > x->keys[i]) i++;
         }
-        bt_insert_nonfull(tree, x->children[i], k, v);
+        x = x->children[i];
     }
 }
 
 void bt_insert(BTree *tree, BTKey k, BTPayload v) {
-    BTreeNode *r = tree->root;
+    bt_write_begin(tree);
+    if (tree->variant == BT_VARIANT_BPLUS) bp_insert(tree, k, v);
+    else bt_insert_classic(tree, k, v);
+    bt_write_end(tree);
+}
+
+void bt_insert_hint(BTree *tree, BTKey k, BTPayload v, const BTPath *hint) {
+    // Another writer may have changed the tree since the hint's search.
+    if (hint && hint->depth > 0 && !hint->found && !tree->sync) {
+        BTreeNode *x = hint->node[hint->depth - 1];
+        int i = hint->slot[hint->depth - 1];
+        // Leaves hold up to 2t-1 keys in both variants.
+        if (x->leaf && x->nkeys < 2*tree->t - 1) {
+            int n = x->nkeys - i;
+            memmove(&x->keys[i+1], &x->keys[i], sizeof(BTKey) * n);
+            memmove(&x->values[i+1], &x->values[i], sizeof(BTPayload) * n);
+            x->keys[i] = k;
+            x->values[i] = v;
+            x->nkeys++;
+            bt_count_add(tree, 1);
+            return;
+        }
+    }
+    bt_insert(tree, k, v);
+}
+
+// ---------------------------------------------------------------------------
+// In-order iteration over an explicit path stack. Invariant: after
+// bt_iter_seek/bt_iter_next, either depth == 0 (exhausted) or the top entry
+// (node, slot) names the current key, node->keys[slot].
+
+// Pop levels whose slot ran past the last key; the first ancestor with a
+// remaining key is the in-order successor.
+static void bt_iter_settle(BTPath *it) {
+    while (it->depth > 0) {
+        int d = it->depth - 1;
+        if (it->slot[d] < it->node[d]->nkeys) return;
+        it->depth--;
+    }
+}
+
+// Position at the first key >= k.
+static void bt_iter_seek(BTPath *it, BTreeNode *root, BTKey k, BTStats *stats) {
+    it->depth = 0;
+    BTreeNode *x = root;
+    while (x) {
+        if (stats) stats->node_visits++;
+        int i = bt_lower_bound(x->keys, x->nkeys, k);
+        it->node[it->depth] = x;
+        it->slot[it->depth] = i;
+        it->depth++;
+        if ((i < x->nkeys && x->keys[i] == k) || x->leaf) break;
+        x = x->children[i];
+    }
+    bt_iter_settle(it);
+}
+
+// Step to the in-order successor of the current key.
+static void bt_iter_next(BTPath *it, BTStats *stats) {
+    int d = it->depth - 1;
+    BTreeNode *x = it->node[d];
+    it->slot[d]++;
+    if (!x->leaf) {
+        // Successor is the leftmost key of the subtree right of the key.
+        x = x->children[it->slot[d]];
+        while (x) {
+            if (stats) stats->node_visits++;
+            it->node[it->depth] = x;
+            it->slot[it->depth] = 0;
+            it->depth++;
+            x = x->leaf ? NULL : x->children[0];
+        }
+    }
+    bt_iter_settle(it);
+}
+
+// Predecessor side of bt_iter_settle: pop levels whose slot ran below
+// zero; an ancestor that descended into child i continues at keys[i-1].
+static void bt_iter_settle_back(BTPath *it) {
+    while (it->depth > 0) {
+        int d = it->depth - 1;
+        if (it->slot[d] >= 0) return;
+        it->depth--;
+        if (it->depth > 0) it->slot[it->depth - 1]--;
+    }
+}
+
+// Push the path to the rightmost key of the subtree rooted at x.
+static void bt_iter_descend_right(BTPath *it, BTreeNode *x, BTStats *stats) {
+    for (;;) {
+        if (stats) stats->node_visits++;
+        it->node[it->depth] = x;
+        it->slot[it->depth] = x->leaf ? x->nkeys - 1 : x->nkeys;
+        it->depth++;
+        if (x->leaf) return;
+        x = x->children[x->nkeys];
+    }
+}
+
+// Step to the in-order predecessor of the current key.
+static void bt_iter_prev(BTPath *it, BTStats *stats) {
+    int d = it->depth - 1;
+    BTreeNode *x = it->node[d];
+    if (!x->leaf) {
+        // Predecessor is the rightmost key of the subtree left of the key.
+        bt_iter_descend_right(it, x->children[it->slot[d]], stats);
+    } else {
+        it->slot[d]--;
+    }
+    bt_iter_settle_back(it);
+}
+
+void bt_range_search(BTree *tree, BTKey lo, BTKey hi,
+                     BTRangeCallback cb, void *arg, BTStats *stats) {
+    if (!tree || !tree->root || lo > hi) return;
+    if (tree->variant == BT_VARIANT_BPLUS) {
+        bp_range_search(tree, lo, hi, cb, arg, stats);
+        return;
+    }
+
+    BTPath it;
+    bt_iter_seek(&it, tree->root, lo, stats);
+    while (it.depth > 0) {
+        BTreeNode *x = it.node[it.depth - 1];
+        int i = it.slot[it.depth - 1];
+        if (x->keys[i] > hi) break;
+        cb(x->keys[i], x->values[i], arg);
+        bt_iter_next(&it, stats);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Delete. Top-down like insert: before descending into a child that holds
+// only t-1 keys, it is topped up by borrowing from a sibling or merged with
+// one, so removing a key from a leaf never underflows.
+
+// Merge children[i], keys[i] and children[i+1] of x into children[i].
+static void bt_merge_children(BTree *tree, BTreeNode *x, int i) {
+    BTreeNode *y = x->children[i];
+    BTreeNode *z = x->children[i+1];
+    bt_wlock(tree, x);
+    bt_wlock(tree, y);
+
+    y->keys[y->nkeys] = x->keys[i];
+    y->values[y->nkeys] = x->values[i];
+    memcpy(&y->keys[y->nkeys + 1], z->keys, sizeof(BTKey) * z->nkeys);
+    memcpy(&y->values[y->nkeys + 1], z->values, sizeof(BTPayload) * z->nkeys);
+    if (!y->leaf)
+        memcpy(&y->children[y->nkeys + 1], z->children,
+               sizeof(BTreeNode*) * (z->nkeys + 1));
+    y->nkeys += z->nkeys + 1;
+
+    int n = x->nkeys - i - 1;
+    memmove(&x->keys[i], &x->keys[i+1], sizeof(BTKey) * n);
+    memmove(&x->values[i], &x->values[i+1], sizeof(BTPayload) * n);
+    memmove(&x->children[i+1], &x->children[i+2], sizeof(BTreeNode*) * n);
+    x->nkeys--;
+
+    bt_retire(tree, z);
+
+    // An internal root emptied by the merge is replaced by its only child.
+    if (x == tree->root && x->nkeys == 0) {
+        bt_wlock_root(tree);
+        tree->root = y;
+        bt_retire(tree, x);
+    }
+}
+
+// Move keys[i-1] of x down to the front of children[i] and the last key of
+// children[i-1] up in its place.
+static void bt_borrow_left(BTree *tree, BTreeNode *x, int i) {
+    BTreeNode *c = x->children[i];
+    BTreeNode *l = x->children[i-1];
+    bt_wlock(tree, x);
+    bt_wlock(tree, l);
+    bt_wlock(tree, c);
+
+    memmove(&c->keys[1], c->keys, sizeof(BTKey) * c->nkeys);
+    memmove(&c->values[1], c->values, sizeof(BTPayload) * c->nkeys);
+    if (!c->leaf)
+        memmove(&c->children[1], c->children, sizeof(BTreeNode*) * (c->nkeys + 1));
+    c->keys[0] = x->keys[i-1];
+    c->values[0] = x->values[i-1];
+    if (!c->leaf)
+        c->children[0] = l->children[l->nkeys];
+    c->nkeys++;
+
+    x->keys[i-1] = l->keys[l->nkeys - 1];
+    x->values[i-1] = l->values[l->nkeys - 1];
+    l->nkeys--;
+}
+
+// Mirror of bt_borrow_left with children[i+1].
+static void bt_borrow_right(BTree *tree, BTreeNode *x, int i) {
+    BTreeNode *c = x->children[i];
+    BTreeNode *r = x->children[i+1];
+    bt_wlock(tree, x);
+    bt_wlock(tree, c);
+    bt_wlock(tree, r);
+
+    c->keys[c->nkeys] = x->keys[i];
+    c->values[c->nkeys] = x->values[i];
+    if (!c->leaf)
+        c->children[c->nkeys + 1] = r->children[0];
+    c->nkeys++;
+
+    x->keys[i] = r->keys[0];
+    x->values[i] = r->values[0];
+    memmove(r->keys, &r->keys[1], sizeof(BTKey) * (r->nkeys - 1));
+    memmove(r->values, &r->values[1], sizeof(BTPayload) * (r->nkeys - 1));
+    if (!r->leaf)
+        memmove(r->children, &r->children[1], sizeof(BTreeNode*) * r->nkeys);
+    r->nkeys--;
+}
+
+// Make sure children[i] of x holds at least t keys before descending into
+// it. Returns the child to descend into (a merge may change it).
+static BTreeNode* bt_fill_child(BTree *tree, BTreeNode *x, int i) {
     int t = tree->t;
-    if (r->nkeys == 2*t - 1) {
-        BTreeNode *s = bt_new_node(t, 0);
-        s->children[0] = r;
-        tree->root = s;
-        bt_split_child(tree, s, 0);
-        bt_insert_nonfull(tree, s, k, v);
+    if (x->children[i]->nkeys >= t) return x->children[i];
+
+    if (i > 0 && x->children[i-1]->nkeys >= t) {
+        bt_borrow_left(tree, x, i);
+    } else if (i < x->nkeys && x->children[i+1]->nkeys >= t) {
+        bt_borrow_right(tree, x, i);
     } else {
-        bt_insert_nonfull(tree, r, k, v);
+        if (i == x->nkeys) i--;
+        BTreeNode *merged = x->children[i];
+        bt_merge_children(tree, x, i);
+        return merged;
     }
+    return x->children[i];
 }
 
-// Range search helper.
-static void bt_range_node(BTreeNode *node, BTKey lo, BTKey hi,
-                          BTRangeCallback cb, void *arg, BTStats *stats, int t) {
-    if (!node) return;
-    if (stats) stats->node_visits++;
+static int bt_delete_classic(BTree *tree, BTKey k) {
+    int t = tree->t;
+    BTreeNode *x = tree->root;
+    for (;;) {
+        int i = bt_lower_bound(x->keys, x->nkeys, k);
+        int hit = i < x->nkeys && x->keys[i] == k;
 
-    int i;
-    for (i = 0; i < node->nkeys; i++) {
-        if (!node->leaf) {
-            if (lo <= node->keys[i])
-                bt_range_node(node->children[i], lo, hi, cb, arg, stats, t);
+        if (x->leaf) {
+            if (!hit) return 0;
+            bt_wlock(tree, x);
+            int n = x->nkeys - i - 1;
+            memmove(&x->keys[i], &x->keys[i+1], sizeof(BTKey) * n);
+            memmove(&x->values[i], &x->values[i+1], sizeof(BTPayload) * n);
+            x->nkeys--;
+            bt_count_add(tree, -1);
+            return 1;
         }
-        if (node->keys[i] >= lo && node->keys[i] <= hi) {
-            cb(node->keys[i], node->values[i], arg);
+
+        if (!hit) {
+            x = bt_fill_child(tree, x, i);
+            continue;
         }
-        if (node->keys[i] > hi) {
-            if (!node->leaf)
-                bt_range_node(node->children[i], lo, hi, cb, arg, stats, t);
-            return;
+
+        // Key in an internal node: replace it by its predecessor or
+        // successor, then go delete that one from the richer child.
+        BTreeNode *y = x->children[i];
+        BTreeNode *z = x->children[i+1];
+        if (y->nkeys >= t) {
+            BTreeNode *p = y;
+            while (!p->leaf) p = p->children[p->nkeys];
+            bt_wlock(tree, x);
+            x->keys[i] = p->keys[p->nkeys - 1];
+            x->values[i] = p->values[p->nkeys - 1];
+            k = x->keys[i];
+            x = y;
+        } else if (z->nkeys >= t) {
+            BTreeNode *p = z;
+            while (!p->leaf) p = p->children[0];
+            bt_wlock(tree, x);
+            x->keys[i] = p->keys[0];
+            x->values[i] = p->values[0];
+            k = x->keys[i];
+            x = z;
+        } else {
+            // Both have t-1 keys: merge them around k and continue in y.
+            bt_merge_children(tree, x, i);
+            x = y;
         }
     }
-    if (!node->leaf) {
-        bt_range_node(node->children[i], lo, hi, cb, arg, stats, t);
+}
+
+int bt_delete(BTree *tree, BTKey k) {
+    if (!tree || !tree->root) return 0;
+    bt_write_begin(tree);
+    int r = tree->variant == BT_VARIANT_BPLUS ? bp_delete(tree, k)
+                                               : bt_delete_classic(tree, k);
+    bt_write_end(tree);
+    return r;
+}
+
+// ---------------------------------------------------------------------------
+// Bottom-up bulk load. Each level is an ordered run of c items (keys) to be
+// packed into g nodes; the g-1 items that fall between nodes become the
+// next level's items, and the g nodes become its children.
+
+// Number of nodes for c items when nodes hold up to cap keys, keeping every
+// node at >= t-1 keys (the B-tree minimum) when there is more than one.
+static size_t bt_bulk_groups(size_t c, int cap, int t) {
+    size_t g = (c + 1 + (size_t)cap) / ((size_t)cap + 1);   // ceil((c+1)/(cap+1))
+    if (g > 1 && (c + 1) / g < (size_t)t) {
+        g = (c + 1) / (size_t)t;
+        if (g < 1) g = 1;
     }
+    return g;
 }
 
-void bt_range_search(BTree *tree, BTKey lo, BTKey hi,
-                     BTRangeCallback cb, void *arg, BTStats *stats) {
+int bt_bulk_load(BTree *tree, const BTKey *keys, const BTPayload *values,
+                 size_t n, double fill_factor) {
+    if (!tree || bt_count_keys(tree) != 0) {
+        fprintf(stderr, "bt_bulk_load: tree must be empty\n");
+        return 0;
+    }
+    for (size_t i = 1; i < n; i++) {
+        if (keys[i] <= keys[i-1]) {
+            fprintf(stderr, "bt_bulk_load: keys must be strictly ascending\n");
+            return 0;
+        }
+    }
+    if (n == 0) return 1;
+    if (tree->variant == BT_VARIANT_BPLUS) {
+        bp_bulk_load(tree, keys, values, n, fill_factor);
+        return 1;
+    }
+
+    int t = tree->t;
+    int cap = (int)(fill_factor * (2*t - 1) + 0.5);
+    if (cap < t - 1) cap = t - 1;
+    if (cap < 1) cap = 1;
+    if (cap > 2*t - 1) cap = 2*t - 1;
+
+    // Items of the level being built, and the nodes of the level below.
+    const BTKey     *ikeys = keys;
+    const BTPayload *ivals = values;
+    BTKey           *own_keys = NULL;
+    BTPayload       *own_vals = NULL;
+    BTreeNode      **below = NULL;
+    size_t c = n;
+    int leaf = 1;
+
+    for (;;) {
+        size_t g = bt_bulk_groups(c, cap, t);
+        size_t per = (c - (g - 1)) / g;
+        size_t extra = (c - (g - 1)) % g;
+
+        BTreeNode **level = (BTreeNode**)malloc(sizeof(BTreeNode*) * g);
+        BTKey     *up_keys = g > 1 ? (BTKey*)malloc(sizeof(BTKey) * (g - 1)) : NULL;
+        BTPayload *up_vals = g > 1 ? (BTPayload*)malloc(sizeof(BTPayload) * (g - 1)) : NULL;
+
+        size_t pos = 0, ci = 0;
+        for (size_t j = 0; j < g; j++) {
+            int q = (int)(per + (j < extra ? 1 : 0));
+            BTreeNode *x = bt_new_node(t, leaf);
+            memcpy(x->keys, ikeys + pos, sizeof(BTKey) * q);
+            memcpy(x->values, ivals + pos, sizeof(BTPayload) * q);
+            x->nkeys = q;
+            pos += q;
+            if (!leaf) {
+                memcpy(x->children, below + ci, sizeof(BTreeNode*) * (q + 1));
+                ci += q + 1;
+            }
+            level[j] = x;
+            if (j + 1 < g) {
+                up_keys[j] = ikeys[pos];
+                up_vals[j] = ivals[pos];
+                pos++;
+            }
+        }
+
+        free(own_keys);
+        free(own_vals);
+        free(below);
+
+        if (g == 1) {
+            bt_release_node(tree->root);   // the empty root leaf
+            tree->root = level[0];
+            free(level);
+            break;
+        }
+
+        ikeys = own_keys = up_keys;
+        ivals = own_vals = up_vals;
+        below = level;
+        c = g - 1;
+        leaf = 0;
+    }
+
+    bt_count_set(tree, n);
+    return 1;
+}
+
+void bt_cursor_seek(BTCursor *c, BTree *tree, BTKey k, BTStats *stats) {
+    c->tree = tree;
+    c->stats = stats;
+    c->path.depth = 0;
     if (!tree || !tree->root) return;
-    bt_range_node(tree->root, lo, hi, cb, arg, stats, tree->t);
+    if (tree->variant == BT_VARIANT_BPLUS) bp_iter_seek(&c->path, tree, k, stats);
+    else bt_iter_seek(&c->path, tree->root, k, stats);
+}
+
+int bt_cursor_valid(const BTCursor *c) {
+    return c->path.depth > 0;
+}
+
+BTKey bt_cursor_key(const BTCursor *c) {
+    int d = c->path.depth - 1;
+    return c->path.node[d]->keys[c->path.slot[d]];
+}
+
+BTPayload bt_cursor_value(const BTCursor *c) {
+    int d = c->path.depth - 1;
+    return c->path.node[d]->values[c->path.slot[d]];
+}
+
+void bt_cursor_first(BTCursor *c, BTree *tree, BTStats *stats) {
+    bt_cursor_seek(c, tree, INT64_MIN, stats);
 }
 
-static size_t bt_count_keys_node(BTreeNode *node) {
-    if (!node) return 0;
-    size_t res = node->nkeys;
-    if (!node->leaf) {
-        for (int i = 0; i <= node->nkeys; i++)
-            res += bt_count_keys_node(node->children[i]);
+void bt_cursor_last(BTCursor *c, BTree *tree, BTStats *stats) {
+    c->tree = tree;
+    c->stats = stats;
+    c->path.depth = 0;
+    if (!tree || !tree->root) return;
+    if (tree->variant == BT_VARIANT_BPLUS) {
+        bp_iter_last(&c->path, tree, stats);
+    } else {
+        bt_iter_descend_right(&c->path, tree->root, stats);
+        bt_iter_settle_back(&c->path);
     }
-    return res;
+}
+
+void bt_cursor_next(BTCursor *c) {
+    if (c->path.depth == 0) return;
+    if (c->tree->variant == BT_VARIANT_BPLUS) bp_iter_next(&c->path, c->stats);
+    else bt_iter_next(&c->path, c->stats);
+}
+
+void bt_cursor_prev(BTCursor *c) {
+    if (c->path.depth == 0) return;
+    if (c->tree->variant == BT_VARIANT_BPLUS) bp_iter_prev(&c->path, c->stats);
+    else bt_iter_prev(&c->path, c->stats);
 }
 
 size_t bt_count_keys(BTree *tree) {
+    if (!tree) return 0;
+    return atomic_load_explicit(&tree->nkeys, memory_order_relaxed);
+}
+
+int bt_height(const BTree *tree) {
     if (!tree || !tree->root) return 0;
-    return bt_count_keys_node(tree->root);
+    int h = 1;
+    for (const BTreeNode *x = tree->root; !x->leaf; x = x->children[0]) h++;
+    return h;
+}
+
+// ---------------------------------------------------------------------------
+// B+tree variant. Leaves hold up to 2t-1 key/payload pairs and are linked
+// both ways; internal nodes hold up to BP_INNER_MAX separators and no
+// payloads. children[i] covers the keys in [keys[i-1], keys[i]). Separators
+// are copies of leaf keys and only route: one may outlive its key after a
+// delete. Insert and delete are top-down, as in the classic tree.
+
+#define BP_INNER_MAX(t) (3*(t) - 1)
+#define BP_INNER_MIN(t) ((BP_INNER_MAX(t) - 1) / 2)
+
+static BTreeNode* bp_new_leaf(int t) {
+    return bt_alloc_node(2*t - 1, 1, 0, 1);
+}
+
+static BTreeNode* bp_new_inner(int t) {
+    return bt_alloc_node(BP_INNER_MAX(t), 0, BP_INNER_MAX(t) + 1, 0);
+}
+
+static int bp_max_keys(const BTree *tree, const BTreeNode *x) {
+    return x->leaf ? 2*tree->t - 1 : BP_INNER_MAX(tree->t);
+}
+
+static int bp_min_keys(const BTree *tree, const BTreeNode *x) {
+    return x->leaf ? tree->t - 1 : BP_INNER_MIN(tree->t);
+}
+
+// Child of internal node x that covers k.
+static int bp_child_slot(const BTreeNode *x, BTKey k) {
+    int i = bt_lower_bound(x->keys, x->nkeys, k);
+    return i + (i < x->nkeys && x->keys[i] == k);
+}
+
+static BTreeNode* bp_find_leaf(BTree *tree, BTKey k, BTStats *stats) {
+    BTreeNode *x = tree->root;
+    while (!x->leaf) {
+        if (stats) stats->node_visits++;
+        x = x->children[bp_child_slot(x, k)];
+    }
+    if (stats) stats->node_visits++;
+    return x;
+}
+
+static BTPayload bp_search(BTree *tree, BTKey k, BTStats *stats) {
+    BTreeNode *x = bp_find_leaf(tree, k, stats);
+    int i = bt_lower_bound(x->keys, x->nkeys, k);
+    return (i < x->nkeys && x->keys[i] == k) ? x->values[i] : NULL;
+}
+
+static BTPayload bp_search_path(BTree *tree, BTKey k, BTPath *path, BTStats *stats) {
+    BTreeNode *x = tree->root;
+    for (;;) {
+        if (stats) stats->node_visits++;
+        int i = x->leaf ? bt_lower_bound(x->keys, x->nkeys, k) : bp_child_slot(x, k);
+        path->node[path->depth] = x;
+        path->slot[path->depth] = i;
+        path->depth++;
+        if (x->leaf) {
+            if (i < x->nkeys && x->keys[i] == k) {
+                path->found = 1;
+                return x->values[i];
+            }
+            return NULL;
+        }
+        x = x->children[i];
+    }
+}
+
+// Split the full child children[i] of x. A leaf keeps its lower t keys and
+// the first key of the new right leaf is copied up as the separator; an
+// internal node moves its middle key up.
+static void bp_split_child(BTree *tree, BTreeNode *x, int i) {
+    int t = tree->t;
+    BTreeNode *y = x->children[i];
+    BTreeNode *z;
+    BTKey sep;
+    bt_wlock(tree, x);
+    bt_wlock(tree, y);
+
+    if (y->leaf) {
+        z = bp_new_leaf(t);
+        z->nkeys = y->nkeys - t;
+        memcpy(z->keys, &y->keys[t], sizeof(BTKey) * z->nkeys);
+        memcpy(z->values, &y->values[t], sizeof(BTPayload) * z->nkeys);
+        y->nkeys = t;
+        z->prev = y;
+        z->next = y->next;
+        bt_wlock(tree, y->next);
+        if (y->next) y->next->prev = z;
+        y->next = z;
+        sep = z->keys[0];
+    } else {
+        int keep = y->nkeys / 2;
+        z = bp_new_inner(t);
+        z->nkeys = y->nkeys - keep - 1;
+        memcpy(z->keys, &y->keys[keep + 1], sizeof(BTKey) * z->nkeys);
+        memcpy(z->children, &y->children[keep + 1], sizeof(BTreeNode*) * (z->nkeys + 1));
+        y->nkeys = keep;
+        sep = y->keys[keep];
+    }
+
+    int n = x->nkeys - i;
+    memmove(&x->keys[i+1], &x->keys[i], sizeof(BTKey) * n);
+    memmove(&x->children[i+2], &x->children[i+1], sizeof(BTreeNode*) * n);
+    x->keys[i] = sep;
+    x->children[i+1] = z;
+    x->nkeys++;
+}
+
+static void bp_insert(BTree *tree, BTKey k, BTPayload v) {
+    BTreeNode *x = tree->root;
+    if (x->nkeys == bp_max_keys(tree, x)) {
+        BTreeNode *s = bp_new_inner(tree->t);
+        s->children[0] = x;
+        bt_wlock_root(tree);
+        tree->root = s;
+        bp_split_child(tree, s, 0);
+        x = s;
+    }
+
+    while (!x->leaf) {
+        int i = bp_child_slot(x, k);
+        BTreeNode *c = x->children[i];
+        if (c->nkeys == bp_max_keys(tree, c)) {
+            bp_split_child(tree, x, i);
+            if (k >= x->keys[i]) i++;
+        }
+        x = x->children[i];
+    }
+
+    int i = bt_lower_bound(x->keys, x->nkeys, k);
+    bt_wlock(tree, x);
+    if (i < x->nkeys && x->keys[i] == k) {
+        x->values[i] = v;
+        return;
+    }
+    int n = x->nkeys - i;
+    memmove(&x->keys[i+1], &x->keys[i], sizeof(BTKey) * n);
+    memmove(&x->values[i+1], &x->values[i], sizeof(BTPayload) * n);
+    x->keys[i] = k;
+    x->values[i] = v;
+    x->nkeys++;
+    bt_count_add(tree, 1);
+}
+
+// Move one key from children[i-1] of x to the front of children[i]. Leaves
+// move the pair and re-copy the separator; internal nodes rotate through
+// keys[i-1].
+static void bp_borrow_left(BTree *tree, BTreeNode *x, int i) {
+    BTreeNode *c = x->children[i];
+    BTreeNode *l = x->children[i-1];
+    bt_wlock(tree, x);
+    bt_wlock(tree, l);
+    bt_wlock(tree, c);
+
+    memmove(&c->keys[1], c->keys, sizeof(BTKey) * c->nkeys);
+    if (c->leaf) {
+        memmove(&c->values[1], c->values, sizeof(BTPayload) * c->nkeys);
+        c->keys[0] = l->keys[l->nkeys - 1];
+        c->values[0] = l->values[l->nkeys - 1];
+        x->keys[i-1] = c->keys[0];
+    } else {
+        memmove(&c->children[1], c->children, sizeof(BTreeNode*) * (c->nkeys + 1));
+        c->keys[0] = x->keys[i-1];
+        c->children[0] = l->children[l->nkeys];
+        x->keys[i-1] = l->keys[l->nkeys - 1];
+    }
+    c->nkeys++;
+    l->nkeys--;
+}
+
+// Mirror of bp_borrow_left with children[i+1].
+static void bp_borrow_right(BTree *tree, BTreeNode *x, int i) {
+    BTreeNode *c = x->children[i];
+    BTreeNode *r = x->children[i+1];
+    bt_wlock(tree, x);
+    bt_wlock(tree, c);
+    bt_wlock(tree, r);
+
+    if (c->leaf) {
+        c->keys[c->nkeys] = r->keys[0];
+        c->values[c->nkeys] = r->values[0];
+        memmove(r->keys, &r->keys[1], sizeof(BTKey) * (r->nkeys - 1));
+        memmove(r->values, &r->values[1], sizeof(BTPayload) * (r->nkeys - 1));
+        x->keys[i] = r->keys[0];
+    } else {
+        c->keys[c->nkeys] = x->keys[i];
+        c->children[c->nkeys + 1] = r->children[0];
+        x->keys[i] = r->keys[0];
+        memmove(r->keys, &r->keys[1], sizeof(BTKey) * (r->nkeys - 1));
+        memmove(r->children, &r->children[1], sizeof(BTreeNode*) * r->nkeys);
+    }
+    c->nkeys++;
+    r->nkeys--;
+}
+
+// Merge children[i+1] of x into children[i]. Leaves drop the separator
+// and unlink the right leaf; internal nodes pull keys[i] down between them.
+static void bp_merge_children(BTree *tree, BTreeNode *x, int i) {
+    BTreeNode *y = x->children[i];
+    BTreeNode *z = x->children[i+1];
+    bt_wlock(tree, x);
+    bt_wlock(tree, y);
+
+    if (y->leaf) {
+        memcpy(&y->keys[y->nkeys], z->keys, sizeof(BTKey) * z->nkeys);
+        memcpy(&y->values[y->nkeys], z->values, sizeof(BTPayload) * z->nkeys);
+        y->nkeys += z->nkeys;
+        y->next = z->next;
+        bt_wlock(tree, z->next);
+        if (z->next) z->next->prev = y;
+    } else {
+        y->keys[y->nkeys] = x->keys[i];
+        memcpy(&y->keys[y->nkeys + 1], z->keys, sizeof(BTKey) * z->nkeys);
+        memcpy(&y->children[y->nkeys + 1], z->children,
+               sizeof(BTreeNode*) * (z->nkeys + 1));
+        y->nkeys += z->nkeys + 1;
+    }
+
+    int n = x->nkeys - i - 1;
+    memmove(&x->keys[i], &x->keys[i+1], sizeof(BTKey) * n);
+    memmove(&x->children[i+1], &x->children[i+2], sizeof(BTreeNode*) * n);
+    x->nkeys--;
+
+    bt_retire(tree, z);
+
+    if (x == tree->root && x->nkeys == 0) {
+        bt_wlock_root(tree);
+        tree->root = y;
+        bt_retire(tree, x);
+    }
+}
+
+// Make sure children[i] of x holds more than the minimum before descending
+// into it. Returns the child to descend into.
+static BTreeNode* bp_fill_child(BTree *tree, BTreeNode *x, int i) {
+    BTreeNode *c = x->children[i];
+    int min = bp_min_keys(tree, c);
+    if (c->nkeys > min) return c;
+
+    if (i > 0 && x->children[i-1]->nkeys > min) {
+        bp_borrow_left(tree, x, i);
+    } else if (i < x->nkeys && x->children[i+1]->nkeys > min) {
+        bp_borrow_right(tree, x, i);
+    } else {
+        if (i == x->nkeys) i--;
+        BTreeNode *merged = x->children[i];
+        bp_merge_children(tree, x, i);
+        return merged;
+    }
+    return c;
+}
+
+static int bp_delete(BTree *tree, BTKey k) {
+    BTreeNode *x = tree->root;
+    while (!x->leaf)
+        x = bp_fill_child(tree, x, bp_child_slot(x, k));
+
+    int i = bt_lower_bound(x->keys, x->nkeys, k);
+    if (i == x->nkeys || x->keys[i] != k) return 0;
+    bt_wlock(tree, x);
+    int n = x->nkeys - i - 1;
+    memmove(&x->keys[i], &x->keys[i+1], sizeof(BTKey) * n);
+    memmove(&x->values[i], &x->values[i+1], sizeof(BTPayload) * n);
+    x->nkeys--;
+    bt_count_add(tree, -1);
+    return 1;
+}
+
+// Bulk load: pack the leaves and chain them, then build internal levels
+// over the leaves' first keys the way the classic loader does.
+static void bp_bulk_load(BTree *tree, const BTKey *keys, const BTPayload *values,
+                         size_t n, double fill_factor) {
+    int t = tree->t;
+    int lcap = (int)(fill_factor * (2*t - 1) + 0.5);
+    if (lcap < t - 1) lcap = t - 1;
+    if (lcap < 1) lcap = 1;
+    if (lcap > 2*t - 1) lcap = 2*t - 1;
+    int icap = (int)(fill_factor * BP_INNER_MAX(t) + 0.5);
+    if (icap < BP_INNER_MIN(t)) icap = BP_INNER_MIN(t);
+    if (icap > BP_INNER_MAX(t)) icap = BP_INNER_MAX(t);
+
+    size_t g = (n + (size_t)lcap - 1) / (size_t)lcap;
+    if (g > 1 && n / g < (size_t)(t - 1)) g = n / (size_t)(t - 1);
+    size_t per = n / g, extra = n % g;
+
+    BTreeNode **below = (BTreeNode**)malloc(sizeof(BTreeNode*) * g);
+    BTKey      *seps = g > 1 ? (BTKey*)malloc(sizeof(BTKey) * (g - 1)) : NULL;
+    size_t pos = 0;
+    for (size_t j = 0; j < g; j++) {
+        int q = (int)(per + (j < extra ? 1 : 0));
+        BTreeNode *x = bp_new_leaf(t);
+        memcpy(x->keys, keys + pos, sizeof(BTKey) * q);
+        memcpy(x->values, values + pos, sizeof(BTPayload) * q);
+        x->nkeys = q;
+        if (j > 0) {
+            seps[j-1] = keys[pos];
+            x->prev = below[j-1];
+            below[j-1]->next = x;
+        }
+        pos += q;
+        below[j] = x;
+    }
+
+    // c separators over c+1 nodes; each level promotes the g-1 separators
+    // that fall between its nodes.
+    size_t c = g - 1;
+    while (c > 0) {
+        g = bt_bulk_groups(c, icap, BP_INNER_MIN(t) + 1);
+        per = (c - (g - 1)) / g;
+        extra = (c - (g - 1)) % g;
+
+        BTreeNode **level = (BTreeNode**)malloc(sizeof(BTreeNode*) * g);
+        BTKey      *up = g > 1 ? (BTKey*)malloc(sizeof(BTKey) * (g - 1)) : NULL;
+        size_t ci = 0;
+        pos = 0;
+        for (size_t j = 0; j < g; j++) {
+            int q = (int)(per + (j < extra ? 1 : 0));
+            BTreeNode *x = bp_new_inner(t);
+            memcpy(x->keys, seps + pos, sizeof(BTKey) * q);
+            memcpy(x->children, below + ci, sizeof(BTreeNode*) * (q + 1));
+            x->nkeys = q;
+            pos += q;
+            ci += q + 1;
+            level[j] = x;
+            if (j + 1 < g) up[j] = seps[pos++];
+        }
+
+        free(seps);
+        free(below);
+        seps = up;
+        below = level;
+        c = g - 1;
+    }
+
+    bt_release_node(tree->root);   // the empty root leaf
+    tree->root = below[0];
+    free(below);
+    bt_count_set(tree, n);
+}
+
+// Iteration walks the leaf chain, so a B+tree cursor's path is just the
+// current leaf and slot (depth 1).
+
+// Move off the end of a leaf onto the next non-empty one, or exhaust.
+static void bp_iter_settle(BTPath *it, BTStats *stats) {
+    while (it->slot[0] >= it->node[0]->nkeys) {
+        BTreeNode *x = it->node[0]->next;
+        if (!x) {
+            it->depth = 0;
+            return;
+        }
+        if (stats) stats->node_visits++;
+        it->node[0] = x;
+        it->slot[0] = 0;
+    }
+}
+
+static void bp_iter_settle_back(BTPath *it, BTStats *stats) {
+    while (it->slot[0] < 0) {
+        BTreeNode *x = it->node[0]->prev;
+        if (!x) {
+            it->depth = 0;
+            return;
+        }
+        if (stats) stats->node_visits++;
+        it->node[0] = x;
+        it->slot[0] = x->nkeys - 1;
+    }
+}
+
+static void bp_iter_seek(BTPath *it, BTree *tree, BTKey k, BTStats *stats) {
+    BTreeNode *x = bp_find_leaf(tree, k, stats);
+    it->node[0] = x;
+    it->slot[0] = bt_lower_bound(x->keys, x->nkeys, k);
+    it->depth = 1;
+    bp_iter_settle(it, stats);
+}
+
+static void bp_iter_last(BTPath *it, BTree *tree, BTStats *stats) {
+    BTreeNode *x = tree->root;
+    while (!x->leaf) {
+        if (stats) stats->node_visits++;
+        x = x->children[x->nkeys];
+    }
+    if (stats) stats->node_visits++;
+    it->node[0] = x;
+    it->slot[0] = x->nkeys - 1;
+    it->depth = 1;
+    bp_iter_settle_back(it, stats);
+}
+
+static void bp_iter_next(BTPath *it, BTStats *stats) {
+    it->slot[0]++;
+    bp_iter_settle(it, stats);
+}
+
+static void bp_iter_prev(BTPath *it, BTStats *stats) {
+    it->slot[0]--;
+    bp_iter_settle_back(it, stats);
+}
+
+static void bp_range_search(BTree *tree, BTKey lo, BTKey hi,
+                            BTRangeCallback cb, void *arg, BTStats *stats) {
+    BTPath it;
+    bp_iter_seek(&it, tree, lo, stats);
+    while (it.depth > 0) {
+        BTreeNode *x = it.node[0];
+        int i = it.slot[0];
+        for (; i < x->nkeys; i++) {
+            if (x->keys[i] > hi) return;
+            cb(x->keys[i], x->values[i], arg);
+        }
+        it.slot[0] = i;
+        bp_iter_settle(&it, stats);
+    }
 }
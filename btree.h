@@ -4,6 +4,7 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <stdatomic.h>
 
 typedef int64_t BTKey;
 typedef void*   BTPayload;
@@ -14,28 +15,153 @@ typedef struct {
 } BTStats;
 
 typedef struct BTreeNode BTreeNode;
+typedef struct BTSync BTSync;
+
+// Tree engine, fixed at creation; both sit behind the same API.
+typedef enum {
+    BT_VARIANT_BTREE = 0,   // classic B-tree: payloads in every node
+    BT_VARIANT_BPLUS        // B+tree: payloads only in leaves, which are
+                            // linked both ways; internal nodes hold only
+                            // separators and children, up to 3t-1 keys in
+                            // about the bytes of a classic node
+} BTVariant;
 
 typedef struct {
-    BTreeNode *root;
-    int        t;   // minimum degree (B-tree parameter)
+    BTreeNode     *root;
+    int            t;      // minimum degree (B-tree parameter)
+    _Atomic size_t nkeys;  // number of keys, maintained on insert/update/
+                           // delete; read it through bt_count_keys
+    BTVariant      variant;
+    BTSync        *sync;   // NULL unless bt_make_concurrent was called
 } BTree;
 
-BTree*  bt_create(int t);
+// Upper bound on tree height for the explicit descent stacks. Non-root
+// nodes hold at least t-1 >= 1 keys, so this is never reached in practice.
+#define BT_MAX_HEIGHT 64
+
+// Descent path recorded by bt_search_path: the node and slot taken at each
+// level, root first. slot is the lower bound of the key in that node (for
+// B+tree internal nodes, the index of the child descended into).
+typedef struct {
+    BTreeNode *node[BT_MAX_HEIGHT];
+    int        slot[BT_MAX_HEIGHT];
+    int        depth;   // number of levels recorded
+    int        found;   // 1 if node[depth-1]->keys[slot[depth-1]] == key
+} BTPath;
+
+BTree*  bt_create(int t);   // classic B-tree
+BTree*  bt_create_variant(int t, BTVariant variant);
+const char* bt_variant_name(BTVariant variant);
 void    bt_free(BTree *tree);
 
+// Switch the tree to optimistic lock coupling. Afterwards bt_search,
+// bt_search_batch (which then searches key by key) and bt_count_keys may
+// run on any number of threads, concurrently with
+// bt_insert, bt_insert_hint and bt_delete. Every node carries a version
+// that writers bump; readers take no locks and restart from the root when
+// a node they passed through changes under them. Writers to one tree are
+// serialized by a latch and lock each node they modify. Nodes removed by
+// merges are kept until bt_free, since a reader may still be inside one:
+// there is no epoch-based reclamation, so a long delete-heavy run keeps
+// every merged-away node and its memory only grows.
+// The other calls (path searches, bulk load, range scans, cursors) still
+// need the tree to themselves.
+void    bt_make_concurrent(BTree *tree);
+// Reader restarts since bt_make_concurrent, a measure of contention; 0 for
+// a tree that is not concurrent.
+long    bt_olc_restarts(const BTree *tree);
+
 // Insert key → payload. (No duplicates handling; last insert "wins")
 void    bt_insert(BTree *tree, BTKey k, BTPayload v);
 
+// bt_insert for a key that a bt_search_path on this same, unmodified tree
+// reported missing, with that path as the hint: if the leaf it ended at
+// has room, the key goes straight in at the recorded slot without another
+// descent. Falls back to bt_insert when the hint is NULL, found, or the
+// leaf is full.
+void    bt_insert_hint(BTree *tree, BTKey k, BTPayload v, const BTPath *hint);
+
+// Delete key, rebalancing by borrow/merge on the way down.
+// Returns 1 if the key was present, 0 otherwise.
+int     bt_delete(BTree *tree, BTKey k);
+
+// Build an empty tree from n strictly ascending keys in O(n), packing
+// nodes level by level to fill_factor of capacity (clamped so every node
+// keeps the B-tree minimum of t-1 keys). Returns 1 on success, 0 if the
+// tree is not empty or the keys are not ascending.
+int     bt_bulk_load(BTree *tree, const BTKey *keys, const BTPayload *values,
+                     size_t n, double fill_factor);
+
 // Search for key; returns payload or NULL if not found.
 // If stats != NULL, it accumulates node visits.
 BTPayload bt_search(BTree *tree, BTKey k, BTStats *stats);
 
+// Look up keys[0..n) and store each payload (or NULL) in out[]. Lookups
+// advance together one level at a time in groups of BT_BATCH_GROUP,
+// prefetching every group member's next node before any of them reads it,
+// so the cache misses of a group overlap instead of running back to back.
+#define BT_BATCH_GROUP 16
+void    bt_search_batch(BTree *tree, const BTKey *keys, size_t n,
+                        BTPayload *out, BTStats *stats);
+
+// Like bt_search, but also records the descent in *path so callers can
+// reuse it instead of searching again.
+BTPayload bt_search_path(BTree *tree, BTKey k, BTPath *path, BTStats *stats);
+
 // Range scan: call callback(k, v, arg) for all keys in [lo, hi].
 typedef void (*BTRangeCallback)(BTKey k, BTPayload v, void *arg);
 void    bt_range_search(BTree *tree, BTKey lo, BTKey hi,
                         BTRangeCallback cb, void *arg, BTStats *stats);
 
-// For stats: approximate number of keys in tree.
+// Ordered, bidirectional cursor over a tree; lives on the caller's stack
+// (no allocation). It keeps the explicit root-to-key path, so next/prev are
+// amortized O(1). After any positioning call the cursor is either on a key
+// or exhausted (stepped off either end). The tree must not be modified
+// while a cursor is in use.
+typedef struct {
+    BTree   *tree;
+    BTPath   path;    // path.depth == 0 when exhausted
+    BTStats *stats;   // optional node-visit accounting
+} BTCursor;
+
+// Position at the first key >= k (lower bound).
+void      bt_cursor_seek(BTCursor *c, BTree *tree, BTKey k, BTStats *stats);
+int       bt_cursor_valid(const BTCursor *c);
+BTKey     bt_cursor_key(const BTCursor *c);
+BTPayload bt_cursor_value(const BTCursor *c);
+void      bt_cursor_first(BTCursor *c, BTree *tree, BTStats *stats);
+void      bt_cursor_last(BTCursor *c, BTree *tree, BTStats *stats);
+// Step to the next / previous key in ascending order.
+void      bt_cursor_next(BTCursor *c);
+void      bt_cursor_prev(BTCursor *c);
+
+// Number of keys in tree. O(1): the count is maintained incrementally.
 size_t  bt_count_keys(BTree *tree);
 
+// Levels from the root to the leaves (0 for an empty tree). A top-down
+// insert or delete visits one node per level.
+int     bt_height(const BTree *tree);
+
+// In-node key search kernel, process-wide. AUTO picks the widest SIMD
+// kernel the CPU supports (AVX2 > SSE4.2 > NEON), else the scalar scan.
+typedef enum {
+    BT_SEARCH_AUTO = 0,
+    BT_SEARCH_SCALAR,   // linear scan (original)
+    BT_SEARCH_BINARY,   // branchless binary search
+    BT_SEARCH_SSE42,    // 2 keys per compare
+    BT_SEARCH_AVX2,     // 4 keys per compare
+    BT_SEARCH_NEON      // 2 keys per compare (aarch64)
+} BTSearchKernel;
+
+// Returns 1 on success, 0 if the kernel is not supported on this CPU
+// (the current kernel is then left unchanged).
+int            bt_set_search_kernel(BTSearchKernel kind);
+BTSearchKernel bt_get_search_kernel(void);
+int            bt_search_kernel_available(BTSearchKernel kind);
+const char*    bt_search_kernel_name(BTSearchKernel kind);
+
+// Node memory layout selected at build time: "packed" (one aligned
+// allocation per node, -DBT_PACKED_NODES) or "split" (default).
+const char* bt_node_layout(void);
+
 #endif // BTREE_H
@@ -0,0 +1,85 @@
+// cmsketch.c
+#include "cmsketch.h"
+#include "hash64.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define CMS_BLOCK      64                      // counters (bytes) per block
+#define CMS_ROW        (CMS_BLOCK / CMS_DEPTH) // counters per row in a block
+
+struct CMSketch {
+    uint8_t *counters;      // nblocks * CMS_BLOCK, 64-byte aligned
+    size_t   nblocks;       // power of two
+    size_t   sample_size;   // increments between halvings
+    size_t   additions;     // increments since the last halving
+};
+
+// Low bits pick the block; each row takes its own 4 bits higher up.
+static uint8_t* cms_block(const CMSketch *s, uint64_t h) {
+    return s->counters + (h & (s->nblocks - 1)) * CMS_BLOCK;
+}
+
+static int cms_slot(uint64_t h, int row) {
+    return row * CMS_ROW + (int)((h >> (40 + 4*row)) & (CMS_ROW - 1));
+}
+
+CMSketch* cms_create(size_t counters, size_t sample_size) {
+    CMSketch *s = (CMSketch*)malloc(sizeof(CMSketch));
+    size_t nblocks = 1;
+    while (nblocks * CMS_BLOCK < counters) nblocks *= 2;
+    s->nblocks = nblocks;
+    s->counters = (uint8_t*)aligned_alloc(CMS_BLOCK, nblocks * CMS_BLOCK);
+    memset(s->counters, 0, nblocks * CMS_BLOCK);
+    s->sample_size = sample_size ? sample_size : nblocks * CMS_BLOCK;
+    s->additions = 0;
+    return s;
+}
+
+void cms_free(CMSketch *s) {
+    if (!s) return;
+    free(s->counters);
+    free(s);
+}
+
+// Halve every counter, eight at a time.
+static void cms_halve(CMSketch *s) {
+    uint64_t *w = (uint64_t*)s->counters;
+    size_t n = s->nblocks * CMS_BLOCK / sizeof(uint64_t);
+    for (size_t i = 0; i < n; i++)
+        w[i] = (w[i] >> 1) & 0x7f7f7f7f7f7f7f7fULL;
+    s->additions /= 2;
+}
+
+uint32_t cms_estimate(const CMSketch *s, uint64_t key) {
+    uint64_t h = mix64(key);
+    const uint8_t *b = cms_block(s, h);
+    uint32_t m = UINT8_MAX;
+    for (int r = 0; r < CMS_DEPTH; r++) {
+        uint32_t c = b[cms_slot(h, r)];
+        if (c < m) m = c;
+    }
+    return m;
+}
+
+uint32_t cms_increment(CMSketch *s, uint64_t key) {
+    uint64_t h = mix64(key);
+    uint8_t *b = cms_block(s, h);
+    int slot[CMS_DEPTH];
+    uint32_t m = UINT8_MAX;
+    for (int r = 0; r < CMS_DEPTH; r++) {
+        slot[r] = cms_slot(h, r);
+        if (b[slot[r]] < m) m = b[slot[r]];
+    }
+    if (m == UINT8_MAX) return m;
+
+    // Conservative update: only counters at the minimum can be too low.
+    for (int r = 0; r < CMS_DEPTH; r++)
+        if (b[slot[r]] == m) b[slot[r]]++;
+
+    if (++s->additions >= s->sample_size) cms_halve(s);
+    return m + 1;
+}
+
+size_t cms_bytes(const CMSketch *s) {
+    return s->nblocks * CMS_BLOCK;
+}
@@ -0,0 +1,34 @@
+// cmsketch.h
+#ifndef CMSKETCH_H
+#define CMSKETCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Count-Min Sketch frequency estimator in the TinyLFU style:
+//  - blocked: all CMS_DEPTH counters of a key sit in one 64-byte block, so
+//    an update or estimate touches a single cache line;
+//  - 8-bit saturating counters with conservative update (only the minimal
+//    counters are incremented);
+//  - aging by periodic halving: after sample_size increments every counter
+//    is halved, so estimates track recent frequency.
+
+#define CMS_DEPTH 4
+
+typedef struct CMSketch CMSketch;
+
+// counters is rounded up to a power of two (at least one block); a
+// sample_size of 0 halves every `counters` increments.
+CMSketch* cms_create(size_t counters, size_t sample_size);
+void      cms_free(CMSketch *s);
+
+// Count one occurrence of key; returns the new estimate.
+uint32_t  cms_increment(CMSketch *s, uint64_t key);
+
+// Current estimate for key.
+uint32_t  cms_estimate(const CMSketch *s, uint64_t key);
+
+// Memory used by the counters, in bytes.
+size_t    cms_bytes(const CMSketch *s);
+
+#endif // CMSKETCH_H
@@ -0,0 +1,174 @@
+// eytzinger.c
+#include "eytzinger.h"
+#include <stdlib.h>
+#include <string.h>
+
+struct EytzSet {
+    // Snapshot: slots 1..n in Eytzinger order (slot 0 unused). keys is
+    // 64-byte aligned, so the 8 descendants 3 levels below slot i (slots
+    // 8i..8i+7) share one cache line.
+    BTKey     *keys;
+    BTPayload *vals;     // NULL = erased
+    size_t     n;
+    size_t     live;     // slots with a non-NULL payload
+
+    // Delta: sorted, at most cap keys, disjoint from the snapshot.
+    BTKey     *dkeys;
+    BTPayload *dvals;
+    size_t     dn, cap;
+
+    size_t     rebuilds;
+};
+
+EytzSet* eytz_create(size_t rebuild_every) {
+    EytzSet *s = (EytzSet*)calloc(1, sizeof(EytzSet));
+    s->cap = rebuild_every ? rebuild_every : 1;
+    s->dkeys = (BTKey*)malloc(sizeof(BTKey) * s->cap);
+    s->dvals = (BTPayload*)malloc(sizeof(BTPayload) * s->cap);
+    return s;
+}
+
+void eytz_free(EytzSet *s) {
+    if (!s) return;
+    free(s->keys);
+    free(s->vals);
+    free(s->dkeys);
+    free(s->dvals);
+    free(s);
+}
+
+// Snapshot slot holding key, or 0. The descent is branchless: i doubles
+// each level and picks the right child when keys[i] < key. On exit the
+// trailing one bits of i are the right turns taken after the last left
+// turn; shifting them (and that turn) out gives the lower bound's slot.
+static size_t ez_find(const EytzSet *s, BTKey key) {
+    size_t i = 1;
+    while (i <= s->n) {
+        __builtin_prefetch(s->keys + 8 * i);    // the 8 nodes 3 levels down
+        i = 2 * i + (s->keys[i] < key);
+    }
+    i >>= __builtin_ffsll((long long)~i);
+    return (i && s->keys[i] == key) ? i : 0;
+}
+
+static size_t ez_delta_lb(const EytzSet *s, BTKey key) {
+    size_t lo = 0, hi = s->dn;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (s->dkeys[mid] < key) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+BTPayload eytz_get(const EytzSet *s, BTKey key, long *probes) {
+    if (probes) (*probes)++;
+    size_t i = ez_find(s, key);
+    if (i) return s->vals[i];
+    if (s->dn == 0) return NULL;
+    if (probes) (*probes)++;
+    size_t j = ez_delta_lb(s, key);
+    return (j < s->dn && s->dkeys[j] == key) ? s->dvals[j] : NULL;
+}
+
+// In-order walk of slots 1..n <-> positions of a sorted array.
+static size_t ez_fill(EytzSet *s, const BTKey *k, const BTPayload *v, size_t i, size_t pos) {
+    if (i > s->n) return pos;
+    pos = ez_fill(s, k, v, 2 * i, pos);
+    s->keys[i] = k[pos];
+    s->vals[i] = v[pos++];
+    return ez_fill(s, k, v, 2 * i + 1, pos);
+}
+
+static size_t ez_drain(const EytzSet *s, BTKey *k, BTPayload *v, size_t i, size_t pos) {
+    if (i > s->n) return pos;
+    pos = ez_drain(s, k, v, 2 * i, pos);
+    if (s->vals[i]) {
+        k[pos] = s->keys[i];
+        v[pos++] = s->vals[i];
+    }
+    return ez_drain(s, k, v, 2 * i + 1, pos);
+}
+
+// Merge the live snapshot keys with the delta into a new snapshot.
+static void ez_rebuild(EytzSet *s) {
+    size_t total = s->live + s->dn;
+    BTKey     *k = (BTKey*)malloc(sizeof(BTKey) * (total + 1));
+    BTPayload *v = (BTPayload*)malloc(sizeof(BTPayload) * (total + 1));
+    BTKey     *ok = k + s->dn;   // old snapshot drained behind room for the delta
+    BTPayload *ov = v + s->dn;
+    ez_drain(s, ok, ov, 1, 0);
+
+    // Merge front to back; the write position never passes the read one.
+    size_t a = 0, b = 0, o = 0;
+    while (a < s->live || b < s->dn) {
+        if (b == s->dn || (a < s->live && ok[a] < s->dkeys[b])) {
+            k[o] = ok[a];
+            v[o++] = ov[a++];
+        } else {
+            k[o] = s->dkeys[b];
+            v[o++] = s->dvals[b++];
+        }
+    }
+
+    free(s->keys);
+    free(s->vals);
+    size_t bytes = (sizeof(BTKey) * (total + 1) + 63) / 64 * 64;
+    s->keys = (BTKey*)aligned_alloc(64, bytes);
+    s->vals = (BTPayload*)malloc(sizeof(BTPayload) * (total + 1));
+    s->n = total;
+    s->live = total;
+    ez_fill(s, k, v, 1, 0);
+    s->dn = 0;
+    s->rebuilds++;
+    free(k);
+    free(v);
+}
+
+void eytz_put(EytzSet *s, BTKey key, BTPayload value) {
+    size_t i = ez_find(s, key);
+    if (i) {
+        if (!s->vals[i] && value) s->live++;
+        else if (s->vals[i] && !value) s->live--;
+        s->vals[i] = value;
+        return;
+    }
+    size_t j = ez_delta_lb(s, key);
+    if (j < s->dn && s->dkeys[j] == key) {
+        s->dvals[j] = value;
+        return;
+    }
+    memmove(&s->dkeys[j + 1], &s->dkeys[j], sizeof(BTKey) * (s->dn - j));
+    memmove(&s->dvals[j + 1], &s->dvals[j], sizeof(BTPayload) * (s->dn - j));
+    s->dkeys[j] = key;
+    s->dvals[j] = value;
+    if (++s->dn == s->cap) ez_rebuild(s);
+}
+
+int eytz_erase(EytzSet *s, BTKey key) {
+    size_t i = ez_find(s, key);
+    if (i) {
+        if (!s->vals[i]) return 0;
+        s->vals[i] = NULL;
+        s->live--;
+        return 1;
+    }
+    size_t j = ez_delta_lb(s, key);
+    if (j == s->dn || s->dkeys[j] != key) return 0;
+    memmove(&s->dkeys[j], &s->dkeys[j + 1], sizeof(BTKey) * (s->dn - j - 1));
+    memmove(&s->dvals[j], &s->dvals[j + 1], sizeof(BTPayload) * (s->dn - j - 1));
+    s->dn--;
+    return 1;
+}
+
+size_t eytz_count(const EytzSet *s) {
+    return s->live + s->dn;
+}
+
+size_t eytz_rebuilds(const EytzSet *s) {
+    return s->rebuilds;
+}
+
+size_t eytz_bytes(const EytzSet *s) {
+    return (s->n + 1 + s->cap) * (sizeof(BTKey) + sizeof(BTPayload));
+}
@@ -0,0 +1,35 @@
+// eytzinger.h
+#ifndef EYTZINGER_H
+#define EYTZINGER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "btree.h"
+
+// Read-optimized key -> payload set for a slowly changing hot tier:
+//  - an immutable snapshot: the sorted keys laid out in Eytzinger (BFS)
+//    order, searched branchlessly while prefetching three levels ahead;
+//  - a small sorted delta buffer that collects new keys and is merged into
+//    a freshly built snapshot once it holds rebuild_every keys.
+// Erasing a snapshot key only clears its payload (the layout stays fixed);
+// cleared slots are dropped at the next rebuild, or revived in place if
+// the key is put back first.
+
+typedef struct EytzSet EytzSet;
+
+// rebuild_every: keys buffered in the delta before a rebuild (>= 1).
+EytzSet*  eytz_create(size_t rebuild_every);
+void      eytz_free(EytzSet *s);
+
+// Payload of key, or NULL. If probes != NULL it is incremented once for
+// the snapshot and once more if the delta had to be searched.
+BTPayload eytz_get(const EytzSet *s, BTKey key, long *probes);
+
+void      eytz_put(EytzSet *s, BTKey key, BTPayload value);
+int       eytz_erase(EytzSet *s, BTKey key);     // 1 if key was present
+
+size_t    eytz_count(const EytzSet *s);
+size_t    eytz_rebuilds(const EytzSet *s);
+size_t    eytz_bytes(const EytzSet *s);
+
+#endif // EYTZINGER_H
@@ -0,0 +1,17 @@
+// hash64.h
+#ifndef HASH64_H
+#define HASH64_H
+
+#include <stdint.h>
+
+// splitmix64 finalizer: a cheap bijective 64-bit mix with full avalanche.
+// Shared by the hashed structures (sketch, filter, hash map, evictor map)
+// and the benchmark's PRNG seeding.
+static inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 30; x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27; x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+#endif // HASH64_H
@@ -0,0 +1,248 @@
+// hcshard.c
+#include "hcshard.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#define HS_MAX_SHARDS 256
+#define HS_BATCH_CHUNK 256
+
+typedef unsigned __int128 hs_u128;
+
+// Order-preserving map of a key to [0, span).
+static uint64_t hs_offset(const HCShardedIndex *s, BTKey k) {
+    return s->max_key == HC_KEY_UNBOUNDED ? (uint64_t)k ^ (1ULL << 63) : (uint64_t)k;
+}
+
+static int hs_route(const HCShardedIndex *s, uint64_t u) {
+    return (int)(((hs_u128)u * s->mult) >> 64);
+}
+
+int hc_shard_of(const HCShardedIndex *s, BTKey k) {
+    if (s->nshards == 1) return 0;
+    if (s->max_key != HC_KEY_UNBOUNDED) {
+        if (k < 0) return 0;
+        if (k > s->max_key) return s->nshards - 1;
+    }
+    return hs_route(s, hs_offset(s, k));
+}
+
+// Key as shard i sees it.
+static BTKey hs_local(const HCShardedIndex *s, int i, BTKey k) {
+    return s->base ? k - s->base[i] : k;
+}
+
+HCShardedIndex* hc_sharded_create(int64_t max_key, int nshards, int btree_degree,
+                                  HCParams params) {
+    if (nshards < 1) nshards = 1;
+    if (nshards > HS_MAX_SHARDS) nshards = HS_MAX_SHARDS;
+    if (max_key != HC_KEY_UNBOUNDED && max_key >= 0 && (uint64_t)nshards > (uint64_t)max_key + 1)
+        nshards = (int)(max_key + 1);
+
+    HCShardedIndex *s = (HCShardedIndex*)calloc(1, sizeof(HCShardedIndex));
+    s->nshards = nshards;
+    s->max_key = max_key;
+    s->shard = (HCIndex**)calloc((size_t)nshards, sizeof(HCIndex*));
+
+    // route(u) = floor(u * mult / 2^64) is monotonic and stays below
+    // nshards for every u in [0, span).
+    if (max_key == HC_KEY_UNBOUNDED) {
+        s->mult = (uint64_t)nshards;
+    } else {
+        uint64_t span = (uint64_t)max_key + 1;
+        s->mult = (uint64_t)((((hs_u128)nshards << 64) - 1) / span);
+        s->base = (BTKey*)malloc(sizeof(BTKey) * (size_t)(nshards + 1));
+        s->base[0] = 0;
+        s->base[nshards] = (BTKey)span;
+        for (int i = 1; i < nshards; i++) {
+            uint64_t lo = (uint64_t)s->base[i-1], hi = span;   // first u routed to >= i
+            while (lo < hi) {
+                uint64_t mid = lo + (hi - lo) / 2;
+                if (hs_route(s, mid) >= i) hi = mid;
+                else lo = mid + 1;
+            }
+            s->base[i] = (BTKey)lo;
+        }
+    }
+
+    for (int i = 0; i < nshards; i++) {
+        int64_t local_max = HC_KEY_UNBOUNDED;
+        if (s->base) {
+            local_max = s->base[i+1] - s->base[i] - 1;
+            if (local_max < 0) local_max = 0;   // empty range
+        }
+        s->shard[i] = hc_create(local_max, btree_degree, params);
+        if (!s->shard[i]) {
+            hc_sharded_free(s);
+            return NULL;
+        }
+    }
+    return s;
+}
+
+void hc_sharded_free(HCShardedIndex *s) {
+    if (!s) return;
+    for (int i = 0; i < s->nshards; i++) hc_free(s->shard[i]);
+    free(s->shard);
+    free(s->base);
+    free(s);
+}
+
+static int hs_in_domain(const HCShardedIndex *s, BTKey k) {
+    return s->max_key == HC_KEY_UNBOUNDED || (k >= 0 && k <= s->max_key);
+}
+
+void hc_sharded_insert(HCShardedIndex *s, BTKey k, BTPayload v) {
+    if (!hs_in_domain(s, k)) {
+        fprintf(stderr,
+                "hc_sharded_insert: key %" PRId64 " out of range [0, %" PRId64 "]\n",
+                (int64_t)k, (int64_t)s->max_key);
+        return;
+    }
+    int i = hc_shard_of(s, k);
+    hc_insert(s->shard[i], hs_local(s, i, k), v);
+}
+
+// Ascending keys route to ascending shards, so each shard's keys are one
+// contiguous run of the input.
+int hc_sharded_bulk_load(HCShardedIndex *s, const BTKey *keys,
+                         const BTPayload *values, size_t n, double fill_factor) {
+    if (n > 0 && (!hs_in_domain(s, keys[0]) || !hs_in_domain(s, keys[n-1]))) {
+        fprintf(stderr,
+                "hc_sharded_bulk_load: keys [%" PRId64 ", %" PRId64 "] out of range [0, %" PRId64 "]\n",
+                (int64_t)keys[0], (int64_t)keys[n-1], (int64_t)s->max_key);
+        return 0;
+    }
+    BTKey *local = s->base && n ? (BTKey*)malloc(sizeof(BTKey) * n) : NULL;
+    int ok = 1;
+    size_t a = 0;
+    while (a < n && ok) {
+        int i = hc_shard_of(s, keys[a]);
+        size_t b = a + 1;
+        while (b < n && hc_shard_of(s, keys[b]) == i) b++;
+        const BTKey *run = keys + a;
+        if (local) {
+            for (size_t j = a; j < b; j++) local[j] = keys[j] - s->base[i];
+            run = local + a;
+        }
+        ok = hc_bulk_load(s->shard[i], run, values + a, b - a, fill_factor);
+        a = b;
+    }
+    free(local);
+    return ok;
+}
+
+BTPayload hc_sharded_search(HCShardedIndex *s, BTKey k) {
+    int i = hc_shard_of(s, k);
+    return hc_search(s->shard[i], hs_local(s, i, k));
+}
+
+int hc_sharded_delete(HCShardedIndex *s, BTKey k) {
+    int i = hc_shard_of(s, k);
+    return hc_delete(s->shard[i], hs_local(s, i, k));
+}
+
+// Counting sort of each chunk by shard, one hc_search_batch per shard,
+// then the payloads are scattered back to input order.
+void hc_sharded_search_batch(HCShardedIndex *s, const BTKey *keys, size_t n,
+                             BTPayload *out) {
+    if (s->nshards == 1) {
+        hc_search_batch(s->shard[0], keys, n, out);
+        return;
+    }
+    int       sh[HS_BATCH_CHUNK];
+    uint16_t  pos[HS_BATCH_CHUNK];
+    BTKey     lk[HS_BATCH_CHUNK];
+    BTPayload lv[HS_BATCH_CHUNK];
+    uint16_t  start[HS_MAX_SHARDS + 1], fill[HS_MAX_SHARDS];
+
+    for (size_t base = 0; base < n; base += HS_BATCH_CHUNK) {
+        size_t m = n - base < HS_BATCH_CHUNK ? n - base : HS_BATCH_CHUNK;
+        memset(start, 0, sizeof(uint16_t) * (size_t)(s->nshards + 1));
+        for (size_t j = 0; j < m; j++) {
+            sh[j] = hc_shard_of(s, keys[base + j]);
+            start[sh[j] + 1]++;
+        }
+        for (int i = 0; i < s->nshards; i++) {
+            start[i + 1] += start[i];
+            fill[i] = start[i];
+        }
+        for (size_t j = 0; j < m; j++) {
+            uint16_t p = fill[sh[j]]++;
+            pos[j] = p;
+            lk[p] = hs_local(s, sh[j], keys[base + j]);
+        }
+        for (int i = 0; i < s->nshards; i++) {
+            if (start[i + 1] > start[i])
+                hc_search_batch(s->shard[i], lk + start[i],
+                                start[i + 1] - start[i], lv + start[i]);
+        }
+        for (size_t j = 0; j < m; j++) out[base + j] = lv[pos[j]];
+    }
+}
+
+typedef struct {
+    BTRangeCallback cb;
+    void           *arg;
+    BTKey           base;
+} HSRangeArg;
+
+static void hs_range_rebase(BTKey k, BTPayload v, void *arg) {
+    HSRangeArg *r = (HSRangeArg*)arg;
+    r->cb(k + r->base, v, r->arg);
+}
+
+void hc_sharded_range_search(HCShardedIndex *s, BTKey lo, BTKey hi,
+                             BTRangeCallback cb, void *arg) {
+    if (s->max_key != HC_KEY_UNBOUNDED) {
+        if (lo < 0) lo = 0;
+        if (hi > s->max_key) hi = s->max_key;
+    }
+    if (lo > hi) return;
+    int i0 = hc_shard_of(s, lo), i1 = hc_shard_of(s, hi);
+    for (int i = i0; i <= i1; i++) {
+        if (!s->base) {
+            hc_range_search(s->shard[i], lo, hi, cb, arg);
+            continue;
+        }
+        BTKey b = s->base[i];
+        HSRangeArg r = { cb, arg, b };
+        BTKey from = i == i0 ? lo : b;
+        BTKey to   = i == i1 ? hi : s->base[i+1] - 1;
+        hc_range_search(s->shard[i], from - b, to - b, hs_range_rebase, &r);
+    }
+}
+
+size_t hc_sharded_scan(HCShardedIndex *s, BTKey lo, size_t n,
+                       BTRangeCallback cb, void *arg) {
+    if (s->max_key != HC_KEY_UNBOUNDED) {
+        if (lo > s->max_key) return 0;
+        if (lo < 0) lo = 0;
+    }
+    size_t done = 0;
+    int first = hc_shard_of(s, lo);
+    for (int i = first; i < s->nshards && done < n; i++) {
+        HCCursor c;
+        if (i == first) hc_cursor_seek(&c, s->shard[i], hs_local(s, i, lo));
+        else hc_cursor_first(&c, s->shard[i]);
+        BTKey b = s->base ? s->base[i] : 0;
+        for (; done < n && hc_cursor_valid(&c); hc_cursor_next(&c), done++)
+            cb(hc_cursor_key(&c) + b, hc_cursor_value(&c), arg);
+    }
+    return done;
+}
+
+void hc_sharded_sync(HCShardedIndex *s) {
+    for (int i = 0; i < s->nshards; i++) hc_sync(s->shard[i]);
+}
+
+HCStats hc_sharded_get_stats(HCShardedIndex *s) {
+    HCStats total;
+    memset(&total, 0, sizeof(total));
+    for (int i = 0; i < s->nshards; i++) {
+        HCStats one = hc_get_stats(s->shard[i]);
+        hc_stats_add(&total, &one);
+    }
+    return total;
+}
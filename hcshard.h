@@ -0,0 +1,62 @@
+// hcshard.h
+#ifndef HCSHARD_H
+#define HCSHARD_H
+
+#include "hctree.h"
+
+// Key-range sharded hot/cold index. The key domain is cut into nshards
+// contiguous ranges, each served by its own HCIndex: its own hot and cold
+// trees, heat state, stats and (with async_promote) promoter. Shards share
+// nothing, so a thread that only touches its own shard needs no locking;
+// with HCParams.concurrent any thread may use any shard.
+//
+// Routing is one 64x64->128-bit multiply. With a bounded domain every
+// shard sees its keys rebased to start at 0, so its dense heat array only
+// covers its own range; an unbounded domain is split evenly over the full
+// int64 range and keys are passed through as they are.
+typedef struct {
+    HCIndex **shard;
+    int       nshards;
+    int64_t   max_key;   // as given to hc_sharded_create
+    uint64_t  mult;      // routing multiplier
+    BTKey    *base;      // first key of each shard's range; base[nshards]
+                         // is one past the last (bounded domain only)
+} HCShardedIndex;
+
+// nshards is clamped to [1, 256] and to at most max_key + 1. Returns NULL
+// if a shard cannot be created (see hc_create).
+HCShardedIndex* hc_sharded_create(int64_t max_key, int nshards, int btree_degree,
+                                  HCParams params);
+void            hc_sharded_free(HCShardedIndex *s);
+
+// Shard serving key k, in [0, nshards). Shards are in key order.
+int             hc_shard_of(const HCShardedIndex *s, BTKey k);
+
+// Same contracts as the hc_* calls, routed to the owning shard(s).
+void      hc_sharded_insert(HCShardedIndex *s, BTKey k, BTPayload v);
+int       hc_sharded_bulk_load(HCShardedIndex *s, const BTKey *keys,
+                               const BTPayload *values, size_t n, double fill_factor);
+BTPayload hc_sharded_search(HCShardedIndex *s, BTKey k);
+int       hc_sharded_delete(HCShardedIndex *s, BTKey k);
+
+// Groups each run of up to 256 keys by shard and hands every group to
+// hc_search_batch. Payloads match n hc_sharded_search calls.
+void      hc_sharded_search_batch(HCShardedIndex *s, const BTKey *keys, size_t n,
+                                  BTPayload *out);
+
+// Calls cb for every key in [lo, hi] once, in ascending order, visiting
+// only the shards whose ranges overlap [lo, hi].
+void      hc_sharded_range_search(HCShardedIndex *s, BTKey lo, BTKey hi,
+                                  BTRangeCallback cb, void *arg);
+
+// Calls cb for the first n keys >= lo, in ascending order, walking HCIndex
+// cursors across shard boundaries. Returns the number of keys visited.
+size_t    hc_sharded_scan(HCShardedIndex *s, BTKey lo, size_t n,
+                          BTRangeCallback cb, void *arg);
+
+void      hc_sharded_sync(HCShardedIndex *s);
+
+// Sum of every shard's hc_get_stats.
+HCStats   hc_sharded_get_stats(HCShardedIndex *s);
+
+#endif // HCSHARD_H
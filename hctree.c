@@ -1,159 +1,1272 @@
 // hctree.c
+#define _POSIX_C_SOURCE 200809L  // clock_gettime, nanosleep, pthreads
 #include "hctree.h"
+#include "hash64.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
 #include <inttypes.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+// ---------------------------------------------------------------------------
+// Hot-tier eviction. Every hot resident owns a slot in a dense array; a
+// key -> slot hash map finds it on a hot hit. The policies share the slot
+// array and read different fields of it:
+//   CLOCK  ref bits swept by a hand,
+//   LRU    last-hit stamps, victim = oldest of HC_LRU_SAMPLES random slots,
+//   SCORE  a binary min-heap of slots ordered by hit score.
+
+#define HC_LRU_SAMPLES 5
+
+typedef struct {
+    BTKey    key;
+    double   score;     // SCORE: hit score at last touch
+    long     stamp;     // LRU: query number of last touch
+    uint32_t heap_pos;  // SCORE: index in heap[]
+    uint8_t  ref;       // CLOCK: referenced since the hand last passed
+} HCSlot;
+
+struct HCEvictor {
+    HCEvictPolicy policy;
+
+    HCSlot   *slots;
+    size_t    nslots, slot_cap;
+    uint32_t *heap;         // SCORE: slot indices, min score on top
+    size_t    hand;         // CLOCK
+
+    // Open addressing (linear probing) key -> slot index + 1; 0 = empty.
+    BTKey    *map_keys;
+    uint32_t *map_vals;
+    size_t    map_mask;
+
+    uint64_t  rng;          // LRU sampling
+};
+
+static size_t hc_map_find(const HCEvictor *e, BTKey k) {
+    size_t i = mix64((uint64_t)k) & e->map_mask;
+    while (e->map_vals[i] && e->map_keys[i] != k)
+        i = (i + 1) & e->map_mask;
+    return i;
+}
+
+static void hc_map_resize(HCEvictor *e, size_t cap);
+
+static void hc_map_put(HCEvictor *e, BTKey k, uint32_t slot) {
+    if (2 * (e->nslots + 1) > e->map_mask + 1)
+        hc_map_resize(e, 2 * (e->map_mask + 1));
+    size_t i = hc_map_find(e, k);
+    e->map_keys[i] = k;
+    e->map_vals[i] = slot + 1;
+}
+
+static void hc_map_resize(HCEvictor *e, size_t cap) {
+    BTKey    *ok = e->map_keys;
+    uint32_t *ov = e->map_vals;
+    size_t    ocap = e->map_mask + 1;
+    e->map_keys = (BTKey*)malloc(sizeof(BTKey) * cap);
+    e->map_vals = (uint32_t*)calloc(cap, sizeof(uint32_t));
+    e->map_mask = cap - 1;
+    for (size_t i = 0; i < ocap; i++) {
+        if (!ov[i]) continue;
+        size_t j = hc_map_find(e, ok[i]);
+        e->map_keys[j] = ok[i];
+        e->map_vals[j] = ov[i];
+    }
+    free(ok);
+    free(ov);
+}
+
+// Remove entry i with backward-shift deletion (no tombstones).
+static void hc_map_erase_at(HCEvictor *e, size_t i) {
+    size_t j = i;
+    for (;;) {
+        j = (j + 1) & e->map_mask;
+        if (!e->map_vals[j]) break;
+        size_t home = mix64((uint64_t)e->map_keys[j]) & e->map_mask;
+        // Move j back into the hole if its home is not in (i, j].
+        if (((j - home) & e->map_mask) >= ((j - i) & e->map_mask)) {
+            e->map_keys[i] = e->map_keys[j];
+            e->map_vals[i] = e->map_vals[j];
+            i = j;
+        }
+    }
+    e->map_vals[i] = 0;
+}
+
+static void hc_heap_swap(HCEvictor *e, size_t a, size_t b) {
+    uint32_t t = e->heap[a];
+    e->heap[a] = e->heap[b];
+    e->heap[b] = t;
+    e->slots[e->heap[a]].heap_pos = (uint32_t)a;
+    e->slots[e->heap[b]].heap_pos = (uint32_t)b;
+}
+
+// Restore heap order around position p after its score changed.
+static void hc_heap_fix(HCEvictor *e, size_t p) {
+    while (p > 0) {
+        size_t parent = (p - 1) / 2;
+        if (e->slots[e->heap[parent]].score <= e->slots[e->heap[p]].score) break;
+        hc_heap_swap(e, p, parent);
+        p = parent;
+    }
+    for (;;) {
+        size_t l = 2*p + 1, r = l + 1, m = p;
+        if (l < e->nslots && e->slots[e->heap[l]].score < e->slots[e->heap[m]].score) m = l;
+        if (r < e->nslots && e->slots[e->heap[r]].score < e->slots[e->heap[m]].score) m = r;
+        if (m == p) break;
+        hc_heap_swap(e, p, m);
+        p = m;
+    }
+}
+
+static HCEvictor* hc_evictor_create(HCEvictPolicy policy) {
+    HCEvictor *e = (HCEvictor*)calloc(1, sizeof(HCEvictor));
+    e->policy = policy;
+    e->slot_cap = 64;
+    e->slots = (HCSlot*)malloc(sizeof(HCSlot) * e->slot_cap);
+    e->heap = (uint32_t*)malloc(sizeof(uint32_t) * e->slot_cap);
+    e->map_mask = 127;
+    e->map_keys = (BTKey*)malloc(sizeof(BTKey) * 128);
+    e->map_vals = (uint32_t*)calloc(128, sizeof(uint32_t));
+    e->rng = 0x9e3779b97f4a7c15ULL;
+    return e;
+}
+
+static void hc_evictor_free(HCEvictor *e) {
+    if (!e) return;
+    free(e->slots);
+    free(e->heap);
+    free(e->map_keys);
+    free(e->map_vals);
+    free(e);
+}
+
+static void hc_evict_admit(HCEvictor *e, BTKey k, double score, long now) {
+    if (e->nslots == e->slot_cap) {
+        e->slot_cap *= 2;
+        e->slots = (HCSlot*)realloc(e->slots, sizeof(HCSlot) * e->slot_cap);
+        e->heap = (uint32_t*)realloc(e->heap, sizeof(uint32_t) * e->slot_cap);
+    }
+    size_t s = e->nslots++;
+    HCSlot *sl = &e->slots[s];
+    sl->key = k;
+    sl->score = score;
+    sl->stamp = now;
+    sl->ref = 1;
+    sl->heap_pos = (uint32_t)s;
+    e->heap[s] = (uint32_t)s;
+    hc_map_put(e, k, (uint32_t)s);
+    if (e->policy == HC_EVICT_SCORE) hc_heap_fix(e, s);
+}
+
+// Record a hot hit on k.
+static void hc_evict_touch(HCEvictor *e, BTKey k, double score, long now) {
+    size_t i = hc_map_find(e, k);
+    if (!e->map_vals[i]) return;
+    HCSlot *sl = &e->slots[e->map_vals[i] - 1];
+    sl->ref = 1;
+    sl->stamp = now;
+    if (e->policy == HC_EVICT_SCORE) {
+        sl->score = score;
+        hc_heap_fix(e, sl->heap_pos);
+    }
+}
+
+// Forget k; the last slot moves into its place to keep slots dense.
+static void hc_evict_remove(HCEvictor *e, BTKey k) {
+    size_t i = hc_map_find(e, k);
+    if (!e->map_vals[i]) return;
+    size_t s = e->map_vals[i] - 1;
+    hc_map_erase_at(e, i);
+
+    size_t last = --e->nslots;
+    size_t hp = e->slots[s].heap_pos;
+    if (hp != last) {
+        hc_heap_swap(e, hp, last);
+    }
+    if (s != last) {
+        e->slots[s] = e->slots[last];
+        e->heap[e->slots[s].heap_pos] = (uint32_t)s;
+        e->map_vals[hc_map_find(e, e->slots[s].key)] = (uint32_t)s + 1;
+    }
+    if (hp < e->nslots) hc_heap_fix(e, hp);
+    if (e->hand >= e->nslots) e->hand = 0;
+}
+
+// Pick the resident to demote. Requires nslots > 0.
+static HCSlot* hc_evict_victim(HCEvictor *e) {
+    switch (e->policy) {
+    case HC_EVICT_CLOCK:
+        for (;;) {
+            HCSlot *sl = &e->slots[e->hand];
+            e->hand = (e->hand + 1) % e->nslots;
+            if (!sl->ref) return sl;
+            sl->ref = 0;
+        }
+    case HC_EVICT_LRU: {
+        HCSlot *best = NULL;
+        for (int j = 0; j < HC_LRU_SAMPLES; j++) {
+            e->rng = e->rng * 6364136223846793005ULL + 1442695040888963407ULL;
+            HCSlot *sl = &e->slots[(e->rng >> 33) % e->nslots];
+            if (!best || sl->stamp < best->stamp) best = sl;
+        }
+        return best;
+    }
+    default:
+        return &e->slots[e->heap[0]];
+    }
+}
+
+const char* hc_hot_tier_name(HCHotTier tier) {
+    switch (tier) {
+    case HC_HOT_TREE: return "tree";
+    case HC_HOT_HASH: return "hash";
+    case HC_HOT_EYTZINGER: return "eytzinger";
+    }
+    return "unknown";
+}
+
+const char* hc_heat_backend_name(HCHeatBackend b) {
+    switch (b) {
+    case HC_HEAT_DENSE:  return "dense";
+    case HC_HEAT_SKETCH: return "sketch";
+    case HC_HEAT_TABLE:  return "table";
+    }
+    return "unknown";
+}
+
+const char* hc_evict_policy_name(HCEvictPolicy p) {
+    switch (p) {
+    case HC_EVICT_NONE:  return "none";
+    case HC_EVICT_CLOCK: return "clock";
+    case HC_EVICT_LRU:   return "lru";
+    case HC_EVICT_SCORE: return "score";
+    }
+    return "unknown";
+}
+
+// ---------------------------------------------------------------------------
+// Sparse hit scores: linear-probing table of the keys that have been hit,
+// grown at 3/4 load. An entry is 16 bytes; score < 0 marks an empty slot.
+
+typedef struct {
+    BTKey    key;
+    float    score;
+    uint32_t epoch;     // epoch of last touch (epoch modes)
+} HCHeatEntry;
+
+struct HCHeatTable {
+    HCHeatEntry *e;
+    size_t       mask;
+    size_t       n;
+};
+
+static HCHeatTable* hc_heat_table_create(size_t cap) {
+    HCHeatTable *t = (HCHeatTable*)malloc(sizeof(HCHeatTable));
+    t->e = (HCHeatEntry*)malloc(sizeof(HCHeatEntry) * cap);
+    for (size_t i = 0; i < cap; i++) t->e[i].score = -1.0f;
+    t->mask = cap - 1;
+    t->n = 0;
+    return t;
+}
+
+static void hc_heat_table_free(HCHeatTable *t) {
+    if (!t) return;
+    free(t->e);
+    free(t);
+}
+
+static size_t hc_heat_table_find(const HCHeatTable *t, BTKey k) {
+    size_t i = mix64((uint64_t)k) & t->mask;
+    while (t->e[i].score >= 0.0f && t->e[i].key != k)
+        i = (i + 1) & t->mask;
+    return i;
+}
+
+// Entry for k, inserted with score 0 if absent.
+static HCHeatEntry* hc_heat_table_get(HCHeatTable *t, BTKey k, uint32_t epoch) {
+    if (4 * (t->n + 1) > 3 * (t->mask + 1)) {
+        HCHeatEntry *old = t->e;
+        size_t ocap = t->mask + 1;
+        t->e = (HCHeatEntry*)malloc(sizeof(HCHeatEntry) * ocap * 2);
+        for (size_t i = 0; i < ocap * 2; i++) t->e[i].score = -1.0f;
+        t->mask = ocap * 2 - 1;
+        for (size_t i = 0; i < ocap; i++)
+            if (old[i].score >= 0.0f) t->e[hc_heat_table_find(t, old[i].key)] = old[i];
+        free(old);
+    }
+    size_t i = hc_heat_table_find(t, k);
+    if (t->e[i].score < 0.0f) {
+        t->e[i].key = k;
+        t->e[i].score = 0.0f;
+        t->e[i].epoch = epoch;
+        t->n++;
+    }
+    return &t->e[i];
+}
+
+// Remove k with backward-shift deletion.
+static void hc_heat_table_erase(HCHeatTable *t, BTKey k) {
+    size_t i = hc_heat_table_find(t, k);
+    if (t->e[i].score < 0.0f) return;
+    size_t j = i;
+    for (;;) {
+        j = (j + 1) & t->mask;
+        if (t->e[j].score < 0.0f) break;
+        size_t home = mix64((uint64_t)t->e[j].key) & t->mask;
+        if (((j - home) & t->mask) >= ((j - i) & t->mask)) {
+            t->e[i] = t->e[j];
+            i = j;
+        }
+    }
+    t->e[i].score = -1.0f;
+    t->n--;
+}
+
+// ---------------------------------------------------------------------------
+
+static int hc_key_in_domain(const HCIndex *idx, BTKey k) {
+    return idx->max_key == HC_KEY_UNBOUNDED || (k >= 0 && k <= idx->max_key);
+}
+
+// ---------------------------------------------------------------------------
+// Cold filter. A Bloom filter cannot drop keys, so it is rebuilt from the
+// cold tree, at twice the key count, once cold outgrows what it was sized
+// for; deleted keys linger as false positives until then.
+
+#define HC_FILTER_MIN_KEYS 1024
+
+static void hc_filter_rebuild(HCIndex *idx, size_t capacity) {
+    if (capacity < HC_FILTER_MIN_KEYS) capacity = HC_FILTER_MIN_KEYS;
+    bloom_free(idx->cold_filter);
+    idx->cold_filter = bloom_create(capacity, idx->params.cold_filter_bits);
+    BTCursor c;
+    for (bt_cursor_first(&c, idx->cold, NULL); bt_cursor_valid(&c); bt_cursor_next(&c))
+        bloom_add(idx->cold_filter, (uint64_t)bt_cursor_key(&c));
+}
+
+// 1 if the filter rules k out of cold.
+static int hc_filter_rejects(const HCIndex *idx, BTKey k) {
+    return idx->cold_filter && !bloom_may_contain(idx->cold_filter, (uint64_t)k);
+}
+
+// ---------------------------------------------------------------------------
+// Concurrent mode counters. Each thread gets a slot (process-wide, handed
+// out on first use) and counts into its own cache-line aligned HCStats in
+// every concurrent index; hc_get_stats adds them up. Without concurrent
+// mode everything counts into idx->stats. Past HC_MAX_THREADS threads,
+// slots are reused and the counts of threads sharing one become approximate.
+
+#define HC_MAX_THREADS 128
+
+struct HCThreadStats {
+    _Alignas(64) HCStats s;
+};
+
+static _Atomic int hc_thread_count;
+static _Thread_local int hc_thread_slot = -1;
+
+static HCStats* hc_st(HCIndex *idx) {
+    if (!idx->tstats) return &idx->stats;
+    if (hc_thread_slot < 0)
+        hc_thread_slot = atomic_fetch_add(&hc_thread_count, 1) % HC_MAX_THREADS;
+    return &idx->tstats[hc_thread_slot].s;
+}
+
+long hc_node_visits(HCIndex *idx) {
+    HCStats *st = hc_st(idx);
+    long n = st->hot_node_visits + st->cold_node_visits;
+    // Cursors always count into idx->stats.
+    if (st != &idx->stats) n += idx->stats.hot_node_visits + idx->stats.cold_node_visits;
+    return n;
+}
+
+void hc_stats_add(HCStats *dst, const HCStats *src) {
+    dst->queries            += src->queries;
+    dst->hot_hits           += src->hot_hits;
+    dst->cold_hits          += src->cold_hits;
+    dst->not_found          += src->not_found;
+    dst->not_found_filtered += src->not_found_filtered;
+    dst->deletes            += src->deletes;
+    dst->promotions         += src->promotions;
+    dst->demotions          += src->demotions;
+    dst->promote_dropped    += src->promote_dropped;
+    dst->hot_bypassed       += src->hot_bypassed;
+    dst->hot_node_visits    += src->hot_node_visits;
+    dst->cold_node_visits   += src->cold_node_visits;
+    dst->hot_rebuilds       += src->hot_rebuilds;
+    dst->olc_restarts       += src->olc_restarts;
+    dst->hot_keys           += src->hot_keys;
+    dst->cold_keys          += src->cold_keys;
+    dst->heat_bytes         += src->heat_bytes;
+    dst->filter_bytes       += src->filter_bytes;
+}
+
+// ---------------------------------------------------------------------------
+// Asynchronous promotion. Candidates go into a bounded MPSC ring (Vyukov's
+// per-cell sequence numbers: producers claim a cell with a CAS on tail, the
+// single consumer owns head). The promoter thread drains up to
+// HC_PROMOTE_BATCH of them, sorts them by key to drop duplicates and to
+// insert in key order, and applies the batch under hot_lock.
+//
+// hot_lock guards the hot tier, the evictor and the promotion counters;
+// the heat state and cold stay with the query thread, which is why a
+// candidate carries everything promotion needs. Deletes and updates bump
+// gen under the lock once cold has changed, and a candidate carries the
+// gen read before its cold lookup, so a candidate made before one is
+// discarded instead of installing a stale or deleted payload.
+
+#define HC_PROMOTE_BATCH 64
+
+typedef struct {
+    BTKey     key;
+    BTPayload value;
+    double    score;
+    long      stamp;     // query number at enqueue (evictor LRU stamp)
+    size_t    cold_keys; // cold size at enqueue (sizes the hot tier)
+    uint64_t  gen;
+} HCCandidate;
+
+typedef struct {
+    _Atomic size_t seq;
+    HCCandidate    c;
+} HCRingCell;
+
+struct HCPromoter {
+    HCRingCell     *cells;
+    size_t          mask;
+    _Atomic size_t  tail;       // producers
+    size_t          head;       // promoter thread only
+    _Atomic long    pushed, applied;
+    _Atomic uint64_t gen;
+    _Atomic int     stop;
+    pthread_mutex_t hot_lock;
+    pthread_t       thread;
+};
+
+static int hc_ring_push(HCPromoter *p, const HCCandidate *c) {
+    size_t pos = atomic_load_explicit(&p->tail, memory_order_relaxed);
+    HCRingCell *cell;
+    for (;;) {
+        cell = &p->cells[pos & p->mask];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(&p->tail, &pos, pos + 1,
+                    memory_order_relaxed, memory_order_relaxed))
+                break;
+        } else if (dif < 0) {
+            return 0;   // full
+        } else {
+            pos = atomic_load_explicit(&p->tail, memory_order_relaxed);
+        }
+    }
+    cell->c = *c;
+    atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+    atomic_fetch_add_explicit(&p->pushed, 1, memory_order_release);
+    return 1;
+}
+
+static int hc_ring_pop(HCPromoter *p, HCCandidate *out) {
+    HCRingCell *cell = &p->cells[p->head & p->mask];
+    if (atomic_load_explicit(&cell->seq, memory_order_acquire) != p->head + 1)
+        return 0;
+    *out = cell->c;
+    atomic_store_explicit(&cell->seq, p->head + p->mask + 1, memory_order_release);
+    p->head++;
+    return 1;
+}
+
+static void hc_hot_lock(HCIndex *idx) {
+    if (idx->promoter) pthread_mutex_lock(&idx->promoter->hot_lock);
+}
+
+static void hc_hot_unlock(HCIndex *idx) {
+    if (idx->promoter) pthread_mutex_unlock(&idx->promoter->hot_lock);
+}
+
+// Concurrent mode has no promoter, but its hot-tier writers race in the
+// same way: a lookup may read k from cold, lose the CPU while another
+// thread updates or deletes k, and then promote the old payload. So every
+// hot-tier write takes lock, updates and deletes bump gen under it after
+// changing cold, and a promotion installs its payload only if gen still
+// has the value read before its cold lookup. Hot readers never take it.
+struct HCWriteLatch {
+    pthread_mutex_t  lock;
+    _Atomic uint64_t gen;
+};
+
+// Hot-tier writes by updates and deletes: hot_lock with a promoter, the
+// write latch in concurrent mode, nothing otherwise.
+static void hc_write_lock(HCIndex *idx) {
+    hc_hot_lock(idx);
+    if (idx->latch) pthread_mutex_lock(&idx->latch->lock);
+}
+
+static void hc_write_unlock(HCIndex *idx) {
+    if (idx->latch) pthread_mutex_unlock(&idx->latch->lock);
+    hc_hot_unlock(idx);
+}
+
+// Generation a promotion candidate carries; read before the cold lookup
+// that yields its payload.
+static uint64_t hc_write_gen(HCIndex *idx) {
+    if (idx->promoter) return atomic_load_explicit(&idx->promoter->gen, memory_order_acquire);
+    if (idx->latch) return atomic_load_explicit(&idx->latch->gen, memory_order_acquire);
+    return 0;
+}
+
+// Cold changed under earlier candidates: discard them. Call with
+// hc_write_lock, after the cold write.
+static void hc_write_invalidate(HCIndex *idx) {
+    if (idx->promoter) atomic_fetch_add(&idx->promoter->gen, 1);
+    if (idx->latch) atomic_fetch_add(&idx->latch->gen, 1);
+}
+
+static void* hc_promoter_main(void *arg);
+
+static HCPromoter* hc_promoter_create(HCIndex *idx, size_t capacity) {
+    size_t cap = 2;
+    while (cap < capacity) cap <<= 1;
+    HCPromoter *p = (HCPromoter*)calloc(1, sizeof(HCPromoter));
+    p->cells = (HCRingCell*)malloc(sizeof(HCRingCell) * cap);
+    p->mask = cap - 1;
+    for (size_t i = 0; i < cap; i++) atomic_init(&p->cells[i].seq, i);
+    pthread_mutex_init(&p->hot_lock, NULL);
+    idx->promoter = p;
+    if (pthread_create(&p->thread, NULL, hc_promoter_main, idx) != 0) {
+        pthread_mutex_destroy(&p->hot_lock);
+        free(p->cells);
+        free(p);
+        idx->promoter = NULL;
+    }
+    return idx->promoter;
+}
+
+static void hc_promoter_free(HCPromoter *p) {
+    if (!p) return;
+    atomic_store(&p->stop, 1);
+    pthread_join(p->thread, NULL);
+    pthread_mutex_destroy(&p->hot_lock);
+    free(p->cells);
+    free(p);
+}
+
+static void hc_pause_us(long us) {
+    struct timespec ts = { 0, us * 1000 };
+    nanosleep(&ts, NULL);
+}
+
+void hc_sync(HCIndex *idx) {
+    HCPromoter *p = idx->promoter;
+    if (!p) return;
+    long target = atomic_load_explicit(&p->pushed, memory_order_acquire);
+    while (atomic_load_explicit(&p->applied, memory_order_acquire) < target)
+        hc_pause_us(20);
+}
 
 HCIndex* hc_create(int64_t max_key, int btree_degree, HCParams params) {
+    if (max_key == HC_KEY_UNBOUNDED && params.heat_backend == HC_HEAT_DENSE) {
+        fprintf(stderr, "hc_create: an unbounded key domain needs a sparse heat backend\n");
+        return NULL;
+    }
+    if (params.hot_tier != HC_HOT_TREE && !params.inclusive) {
+        fprintf(stderr, "hc_create: a %s hot tier needs inclusive mode\n",
+                hc_hot_tier_name(params.hot_tier));
+        return NULL;
+    }
+    if (params.async_promote && !params.inclusive) {
+        fprintf(stderr, "hc_create: asynchronous promotion needs inclusive mode\n");
+        return NULL;
+    }
+    if (params.concurrent &&
+        (!params.inclusive || params.hot_tier != HC_HOT_TREE ||
+         params.heat_backend != HC_HEAT_DENSE || params.epoch_mode != HC_EPOCH_NONE ||
+         params.evict_policy != HC_EVICT_NONE || params.cold_filter_bits > 0.0 ||
+         params.async_promote)) {
+        fprintf(stderr, "hc_create: concurrent mode needs inclusive mode, a tree hot tier "
+                        "and dense heat, without epochs, eviction, filter or async promotion\n");
+        return NULL;
+    }
+
     HCIndex *idx = (HCIndex*)malloc(sizeof(HCIndex));
-    idx->hot = bt_create(btree_degree);
-    idx->cold = bt_create(btree_degree);
+    idx->hot = NULL;
+    idx->hot_map = NULL;
+    idx->hot_snap = NULL;
+    if (params.hot_tier == HC_HOT_HASH) {
+        double cap = max_key == HC_KEY_UNBOUNDED
+                   ? 0.0 : params.max_hot_fraction * (double)(max_key + 1);
+        idx->hot_map = hotmap_create(cap > 1024.0 ? (size_t)cap : 1024);
+    } else if (params.hot_tier == HC_HOT_EYTZINGER) {
+        idx->hot_snap = eytz_create(params.hot_rebuild_every ? params.hot_rebuild_every : 64);
+    } else {
+        idx->hot = bt_create_variant(btree_degree, params.hot_variant);
+    }
+    idx->cold = bt_create_variant(btree_degree, params.cold_variant);
 
     idx->max_key = max_key;
-    idx->hit_score = (double*)calloc((size_t)(max_key + 1), sizeof(double));
+    idx->hit_score = NULL;
+    idx->last_epoch = NULL;
+    idx->sketch = NULL;
+    idx->heat_table = NULL;
+    if (params.heat_backend == HC_HEAT_SKETCH) {
+        size_t counters = params.sketch_counters;
+        if (counters == 0 && max_key == HC_KEY_UNBOUNDED) {
+            counters = (size_t)1 << 16;
+        } else if (counters == 0) {
+            // TinyLFU sizing: a few counters per hot-tier slot.
+            double hot_cap = params.max_hot_fraction * (double)(max_key + 1);
+            counters = hot_cap > 512.0 ? (size_t)(8.0 * hot_cap) : 4096;
+        }
+        idx->sketch = cms_create(counters, params.sketch_sample);
+    } else if (params.heat_backend == HC_HEAT_TABLE) {
+        idx->heat_table = hc_heat_table_create(1024);
+    } else {
+        idx->hit_score = (double*)calloc((size_t)(max_key + 1), sizeof(double));
+        if (params.epoch_mode != HC_EPOCH_NONE)
+            idx->last_epoch = (uint32_t*)calloc((size_t)(max_key + 1), sizeof(uint32_t));
+    }
+    idx->epoch = 0;
+    idx->epoch_t0 = 0.0;
+
+    idx->evictor = params.evict_policy != HC_EVICT_NONE
+                 ? hc_evictor_create(params.evict_policy) : NULL;
+
+    idx->cold_filter = params.cold_filter_bits > 0.0
+                     ? bloom_create(HC_FILTER_MIN_KEYS, params.cold_filter_bits) : NULL;
 
     idx->params = params;
     memset(&idx->stats, 0, sizeof(HCStats));
 
+    idx->tstats = NULL;
+    idx->latch = NULL;
+    if (params.concurrent) {
+        bt_make_concurrent(idx->hot);
+        bt_make_concurrent(idx->cold);
+        idx->tstats = (HCThreadStats*)aligned_alloc(64, sizeof(HCThreadStats) * HC_MAX_THREADS);
+        memset(idx->tstats, 0, sizeof(HCThreadStats) * HC_MAX_THREADS);
+        idx->latch = (HCWriteLatch*)malloc(sizeof(HCWriteLatch));
+        pthread_mutex_init(&idx->latch->lock, NULL);
+        atomic_init(&idx->latch->gen, 0);
+    }
+
+    idx->promoter = NULL;
+    if (params.async_promote &&
+        !hc_promoter_create(idx, params.promote_queue ? params.promote_queue : 4096)) {
+        fprintf(stderr, "hc_create: cannot start the promoter thread\n");
+        hc_free(idx);
+        return NULL;
+    }
+
     return idx;
 }
 
 void hc_free(HCIndex *idx) {
     if (!idx) return;
+    hc_promoter_free(idx->promoter);
     bt_free(idx->hot);
+    hotmap_free(idx->hot_map);
+    eytz_free(idx->hot_snap);
     bt_free(idx->cold);
+    bloom_free(idx->cold_filter);
     free(idx->hit_score);
+    free(idx->last_epoch);
+    cms_free(idx->sketch);
+    hc_heat_table_free(idx->heat_table);
+    hc_evictor_free(idx->evictor);
+    free(idx->tstats);
+    if (idx->latch) pthread_mutex_destroy(&idx->latch->lock);
+    free(idx->latch);
     free(idx);
 }
 
+static BTPayload hc_hot_get(HCIndex *idx, BTKey k, long *visits, BTPath *path);
+static void      hc_hot_put(HCIndex *idx, BTKey k, BTPayload v, const BTPath *hint);
+
 void hc_insert(HCIndex *idx, BTKey k, BTPayload v) {
-    // For this project, we assume 0 <= k <= max_key.
-    if (k < 0 || k > idx->max_key) {
+    if (!hc_key_in_domain(idx, k)) {
     fprintf(stderr,
             "hc_insert: key %" PRId64 " out of range [0, %" PRId64 "]\n",
             (int64_t)k, (int64_t)idx->max_key);
     return;
 }
     bt_insert(idx->cold, k, v);
+    if (idx->cold_filter) {
+        size_t n = bt_count_keys(idx->cold);
+        if (n > bloom_capacity(idx->cold_filter)) hc_filter_rebuild(idx, 2 * n);
+        else bloom_add(idx->cold_filter, (uint64_t)k);
+    }
+    // An update must reach the hot copy, and must not be undone by a
+    // candidate carrying the old payload. Cold is written first, so
+    // candidates stamped after the invalidation read the new payload. The
+    // hot copy is refreshed from cold, which is current even when another
+    // thread updated k after this insert.
+    hc_write_lock(idx);
+    hc_write_invalidate(idx);
+    if (hc_hot_get(idx, k, NULL, NULL) != NULL)
+        hc_hot_put(idx, k, idx->latch ? bt_search(idx->cold, k, NULL) : v, NULL);
+    hc_write_unlock(idx);
+}
+
+int hc_bulk_load(HCIndex *idx, const BTKey *keys, const BTPayload *values,
+                 size_t n, double fill_factor) {
+    // Keys are ascending, so checking the ends covers the whole input.
+    if (n > 0 && (!hc_key_in_domain(idx, keys[0]) || !hc_key_in_domain(idx, keys[n-1]))) {
+        fprintf(stderr,
+                "hc_bulk_load: keys [%" PRId64 ", %" PRId64 "] out of range [0, %" PRId64 "]\n",
+                (int64_t)keys[0], (int64_t)keys[n-1], (int64_t)idx->max_key);
+        return 0;
+    }
+    if (!bt_bulk_load(idx->cold, keys, values, n, fill_factor)) return 0;
+    if (idx->cold_filter) hc_filter_rebuild(idx, n);
+    return 1;
+}
+
+// ---------------------------------------------------------------------------
+// Hit scores.
+
+static double hc_monotonic_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Advance the current epoch. Wall-clock epochs read the clock only every
+// 64 queries.
+static void hc_advance_epoch(HCIndex *idx) {
+    const HCParams *p = &idx->params;
+    if (p->epoch_mode == HC_EPOCH_QUERIES) {
+        if (p->epoch_length >= 1.0)
+            idx->epoch = (uint32_t)((double)idx->stats.queries / p->epoch_length);
+    } else if (p->epoch_mode == HC_EPOCH_SECONDS && (idx->stats.queries & 63) == 1) {
+        double now = hc_monotonic_seconds();
+        if (idx->epoch_t0 == 0.0) idx->epoch_t0 = now;
+        if (p->epoch_length > 0.0)
+            idx->epoch = (uint32_t)((now - idx->epoch_t0) / p->epoch_length);
+    }
+}
+
+// Dense scores are read and written with relaxed atomics (plain moves on
+// the usual targets), so concurrent touches of one key may lose a hit but
+// never tear a score.
+static double hc_dense_load(const HCIndex *idx, BTKey k) {
+    return atomic_load_explicit((_Atomic double*)&idx->hit_score[k], memory_order_relaxed);
+}
+
+static void hc_dense_store(HCIndex *idx, BTKey k, double s) {
+    atomic_store_explicit((_Atomic double*)&idx->hit_score[k], s, memory_order_relaxed);
+}
+
+// Score of k aged to the current epoch (without counting a hit).
+static double hc_age(const HCIndex *idx, double s, uint32_t last) {
+    uint32_t elapsed = idx->epoch - last;
+    if (elapsed && s != 0.0) s *= pow(idx->params.decay_alpha, (double)elapsed);
+    return s;
+}
+
+static double hc_score_now(const HCIndex *idx, BTKey k) {
+    if (idx->sketch) return (double)cms_estimate(idx->sketch, (uint64_t)k);
+    if (idx->heat_table) {
+        const HCHeatTable *t = idx->heat_table;
+        const HCHeatEntry *e = &t->e[hc_heat_table_find(t, k)];
+        if (e->score < 0.0f) return 0.0;
+        return idx->params.epoch_mode != HC_EPOCH_NONE
+             ? hc_age(idx, e->score, e->epoch) : e->score;
+    }
+    double s = hc_dense_load(idx, k);
+    if (idx->last_epoch) s = hc_age(idx, s, idx->last_epoch[k]);
+    return s;
+}
+
+// Count one hit on k and return its new score.
+static double hc_touch(HCIndex *idx, BTKey k) {
+    if (idx->sketch) return (double)cms_increment(idx->sketch, (uint64_t)k);
+    if (idx->heat_table) {
+        HCHeatEntry *e = hc_heat_table_get(idx->heat_table, k, idx->epoch);
+        double s = idx->params.epoch_mode != HC_EPOCH_NONE
+                 ? hc_age(idx, e->score, e->epoch) + 1.0
+                 : idx->params.decay_alpha * e->score + 1.0;
+        e->score = (float)s;
+        e->epoch = idx->epoch;
+        return s;
+    }
+    double s;
+    if (idx->last_epoch) {
+        s = hc_score_now(idx, k) + 1.0;
+        idx->last_epoch[k] = idx->epoch;
+    } else {
+        s = idx->params.decay_alpha * hc_dense_load(idx, k) + 1.0;
+    }
+    hc_dense_store(idx, k, s);
+    return s;
+}
+
+// Hot-tier access for any structure. visits (may be NULL) accumulates
+// node visits, or the tier's probe count (see HCStats.hot_node_visits).
+// path (may be NULL) receives the descent of a hot tree, for use as an
+// insert hint; it is left empty for the other tiers.
+static BTPayload hc_hot_get(HCIndex *idx, BTKey k, long *visits, BTPath *path) {
+    if (path) path->depth = 0;
+    if (idx->hot_map) return hotmap_get(idx->hot_map, k, visits);
+    if (idx->hot_snap) return eytz_get(idx->hot_snap, k, visits);
+    BTStats s = {0};
+    BTPayload v = path ? bt_search_path(idx->hot, k, path, &s)
+                       : bt_search(idx->hot, k, &s);
+    if (visits) *visits += s.node_visits;
+    return v;
+}
+
+static void hc_hot_put(HCIndex *idx, BTKey k, BTPayload v, const BTPath *hint) {
+    if (idx->hot_map) hotmap_put(idx->hot_map, k, v);
+    else if (idx->hot_snap) eytz_put(idx->hot_snap, k, v);
+    else bt_insert_hint(idx->hot, k, v, hint);
+}
+
+static int hc_hot_erase(HCIndex *idx, BTKey k) {
+    if (idx->hot_map) return hotmap_erase(idx->hot_map, k);
+    if (idx->hot_snap) return eytz_erase(idx->hot_snap, k);
+    return bt_delete(idx->hot, k);
+}
+
+static size_t hc_hot_count(const HCIndex *idx) {
+    if (idx->hot_map) return hotmap_count(idx->hot_map);
+    if (idx->hot_snap) return eytz_count(idx->hot_snap);
+    return bt_count_keys(idx->hot);
 }
 
-// Internal: promote key into hot if needed.
-static void maybe_promote(HCIndex *idx, BTKey k) {
+// Internal: promote candidate c, whose cold payload the caller just read,
+// into hot if there is room. hot_miss is the hot descent that missed the
+// key in the hot tier as it is now (empty path for non-tree tiers); NULL
+// if hot may have changed since, in which case hot is checked again.
+// Touches only hot, the evictor and the promotion counters, so the
+// promoter thread can run it under hot_lock.
+static void maybe_promote(HCIndex *idx, const HCCandidate *c, const BTPath *hot_miss) {
     if (!idx->params.inclusive) {
         // We only implement inclusive mode in this standalone version.
         return;
     }
+    BTKey k = c->key;
+    HCStats *st = hc_st(idx);
 
-    size_t total_keys = (size_t)(idx->max_key + 1);
-    size_t hot_keys   = bt_count_keys(idx->hot);
-    size_t cold_keys  = bt_count_keys(idx->cold);
-    (void)cold_keys; // not strictly needed for inclusive mode
+    // Both counts are O(1); in inclusive mode cold holds every key.
+    size_t hot_keys   = hc_hot_count(idx);
+    size_t total_keys = c->cold_keys;
 
     double max_hot = idx->params.max_hot_fraction * (double)total_keys;
+    if (max_hot < 1.0) return;
+
+    // If key already in hot, nothing to do.
+    if (!hot_miss && hc_hot_get(idx, k, NULL, NULL) != NULL) return;
+
     if ((double)hot_keys >= max_hot) {
-        return; // hot index already at capacity
+        HCEvictor *e = idx->evictor;
+        if (!e || e->nslots == 0) return; // hot index frozen at capacity
+
+        // Demote until there is room; the score policy only demotes
+        // residents colder than the candidate.
+        while ((double)hc_hot_count(idx) >= max_hot && e->nslots > 0) {
+            HCSlot *victim = hc_evict_victim(e);
+            // The promoter cannot read live scores; it compares against
+            // the score the victim had at its last hot hit.
+            double victim_score = idx->promoter ? victim->score
+                                                : hc_score_now(idx, victim->key);
+            if (e->policy == HC_EVICT_SCORE && victim_score >= c->score) return;
+            BTKey vk = victim->key;
+            hc_evict_remove(e, vk);
+            hc_hot_erase(idx, vk);
+            st->demotions++;
+            hot_miss = NULL;    // the demotion reshaped hot; drop the hint
+        }
     }
 
-    // If key already in hot, nothing to do.
-    BTStats s = {0};
-    BTPayload existing = bt_search(idx->hot, k, &s);
-    if (existing != NULL) return;
+    hc_hot_put(idx, k, c->value, hot_miss);
+    st->promotions++;
+    if (idx->evictor) hc_evict_admit(idx->evictor, k, c->score, c->stamp);
+}
 
-    // Key must exist in cold; fetch payload.
-    BTStats s2 = {0};
-    BTPayload v = bt_search(idx->cold, k, &s2);
-    if (v == NULL) return; // not found; nothing to promote
+static int hc_candidate_cmp(const void *a, const void *b) {
+    const HCCandidate *x = (const HCCandidate*)a, *y = (const HCCandidate*)b;
+    if (x->key != y->key) return x->key < y->key ? -1 : 1;
+    return (x->stamp > y->stamp) - (x->stamp < y->stamp);
+}
 
-    bt_insert(idx->hot, k, v);
+// Apply one drained batch: the latest candidate per key, in key order.
+static void hc_promote_batch(HCIndex *idx, HCCandidate *batch, size_t n) {
+    qsort(batch, n, sizeof(HCCandidate), hc_candidate_cmp);
+    hc_hot_lock(idx);
+    uint64_t gen = atomic_load_explicit(&idx->promoter->gen, memory_order_relaxed);
+    for (size_t i = 0; i < n; i++) {
+        if (i + 1 < n && batch[i + 1].key == batch[i].key) continue;
+        if (batch[i].gen == gen) maybe_promote(idx, &batch[i], NULL);
+    }
+    hc_hot_unlock(idx);
 }
 
-// Point lookup: hot first, then cold.
-BTPayload hc_search(HCIndex *idx, BTKey k) {
-    idx->stats.queries++;
+static void* hc_promoter_main(void *arg) {
+    HCIndex *idx = (HCIndex*)arg;
+    HCPromoter *p = idx->promoter;
+    HCCandidate batch[HC_PROMOTE_BATCH];
+    while (!atomic_load_explicit(&p->stop, memory_order_relaxed)) {
+        size_t n = 0;
+        while (n < HC_PROMOTE_BATCH && hc_ring_pop(p, &batch[n])) n++;
+        if (n == 0) {
+            hc_pause_us(50);
+            continue;
+        }
+        hc_promote_batch(idx, batch, n);
+        atomic_fetch_add_explicit(&p->applied, (long)n, memory_order_release);
+    }
+    return NULL;
+}
+
+// Per-lookup bookkeeping shared by hc_search and hc_search_batch.
+static void hc_begin_query(HCIndex *idx) {
+    HCStats *st = hc_st(idx);
+    st->queries++;
+    if (idx->params.epoch_mode != HC_EPOCH_NONE) hc_advance_epoch(idx);
+}
+
+static _Thread_local HCOutcome hc_outcome = HC_OUTCOME_MISS;
 
-    BTStats hot_s = {0};
-    BTPayload v = bt_search(idx->hot, k, &hot_s);
-    idx->stats.hot_node_visits += hot_s.node_visits;
+HCOutcome hc_last_outcome(void) {
+    return hc_outcome;
+}
 
+static void hc_hot_hit(HCIndex *idx, BTKey k) {
+    HCStats *st = hc_st(idx);
+    st->hot_hits++;
+    hc_outcome = HC_OUTCOME_HOT_HIT;
+    if (hc_key_in_domain(idx, k)) {
+        double score = hc_touch(idx, k);
+        // We don't re-promote; already hot.
+        if (idx->evictor)
+            hc_evict_touch(idx->evictor, k, score, st->queries);
+    }
+}
+
+// Inline promotion. In concurrent mode it runs under the write latch, and
+// only if no update or delete has changed cold since c->gen was read. The
+// hot_miss hint is dropped there: another reader may have promoted k since
+// the descent, and promotions do not bump gen, so "already hot" must be
+// checked again under the latch.
+static void hc_promote_inline(HCIndex *idx, const HCCandidate *c, const BTPath *hot_miss) {
+    if (!idx->latch) {
+        maybe_promote(idx, c, hot_miss);
+        return;
+    }
+    pthread_mutex_lock(&idx->latch->lock);
+    if (atomic_load_explicit(&idx->latch->gen, memory_order_relaxed) == c->gen)
+        maybe_promote(idx, c, NULL);
+    pthread_mutex_unlock(&idx->latch->lock);
+}
+
+// v is the cold result for k, looked up after reading gen (hc_write_gen);
+// hot_miss as for maybe_promote.
+static void hc_cold_result(HCIndex *idx, BTKey k, BTPayload v, uint64_t gen,
+                           const BTPath *hot_miss) {
+    HCStats *st = hc_st(idx);
     if (v != NULL) {
-        idx->stats.hot_hits++;
-        if (k >= 0 && k <= idx->max_key) {
-            double old = idx->hit_score[k];
-            idx->hit_score[k] = idx->params.decay_alpha * old + 1.0;
-            // We don't re-promote; already hot.
+        st->cold_hits++;
+        hc_outcome = HC_OUTCOME_COLD_HIT;
+        if (hc_key_in_domain(idx, k)) {
+            double new_score = hc_touch(idx, k);
+            if (new_score >= idx->params.hot_threshold) {
+                HCCandidate c = { k, v, new_score, st->queries,
+                                  bt_count_keys(idx->cold), gen };
+                if (!idx->promoter) {
+                    long before = st->promotions;
+                    hc_promote_inline(idx, &c, hot_miss);
+                    if (st->promotions != before) hc_outcome = HC_OUTCOME_PROMOTED;
+                } else {
+                    if (hc_ring_push(idx->promoter, &c)) hc_outcome = HC_OUTCOME_PROMOTED;
+                    else st->promote_dropped++;
+                }
+            }
         }
-        return v;
+    } else {
+        st->not_found++;
+        hc_outcome = HC_OUTCOME_MISS;
     }
+}
 
-    BTStats cold_s = {0};
-    v = bt_search(idx->cold, k, &cold_s);
-    idx->stats.cold_node_visits += cold_s.node_visits;
+// Point lookup: hot first, then cold. A promotion reuses the cold payload
+// and inserts along the hot descent that just missed. With a promoter the
+// promotion is only queued, and a hot tier locked by it is skipped.
+BTPayload hc_search(HCIndex *idx, BTKey k) {
+    HCStats *st = hc_st(idx);
+    hc_begin_query(idx);
 
-    if (v != NULL) {
-        idx->stats.cold_hits++;
-        if (k >= 0 && k <= idx->max_key) {
-            double old = idx->hit_score[k];
-            double new_score = idx->params.decay_alpha * old + 1.0;
-            idx->hit_score[k] = new_score;
-            if (new_score >= idx->params.hot_threshold)
-                maybe_promote(idx, k);
+    // Other threads may change hot before a promotion: no hint then.
+    BTPath hot_path, *hint = idx->tstats ? NULL : &hot_path;
+    BTPayload v;
+    if (!idx->promoter) {
+        v = hc_hot_get(idx, k, &st->hot_node_visits, hint);
+        if (v != NULL) {
+            hc_hot_hit(idx, k);
+            return v;
         }
-        return v;
+    } else if (pthread_mutex_trylock(&idx->promoter->hot_lock) == 0) {
+        v = hc_hot_get(idx, k, &st->hot_node_visits, NULL);
+        if (v != NULL) hc_hot_hit(idx, k);
+        pthread_mutex_unlock(&idx->promoter->hot_lock);
+        if (v != NULL) return v;
     } else {
-        idx->stats.not_found++;
+        st->hot_bypassed++;
+    }
+
+    if (hc_filter_rejects(idx, k)) {
+        st->not_found_filtered++;
+        hc_cold_result(idx, k, NULL, 0, NULL);
         return NULL;
     }
+
+    BTStats cold_s = {0};
+    uint64_t gen = hc_write_gen(idx);
+    v = bt_search(idx->cold, k, &cold_s);
+    st->cold_node_visits += cold_s.node_visits;
+    hc_cold_result(idx, k, v, gen, idx->promoter ? NULL : hint);
+    return v;
+}
+
+// Batched lookup in chunks of HC_BATCH_CHUNK: one batched pass over hot,
+// one over cold for the hot misses the filter lets through, then the
+// per-key bookkeeping in input order. Promotions made by a chunk take
+// effect for the next chunk.
+#define HC_BATCH_CHUNK 256
+
+void hc_search_batch(HCIndex *idx, const BTKey *keys, size_t n, BTPayload *out) {
+    HCStats  *st = hc_st(idx);
+    BTKey     miss_keys[HC_BATCH_CHUNK];
+    BTPayload miss_vals[HC_BATCH_CHUNK];
+    size_t    miss_pos[HC_BATCH_CHUNK];
+
+    for (size_t base = 0; base < n; base += HC_BATCH_CHUNK) {
+        size_t m = n - base < HC_BATCH_CHUNK ? n - base : HC_BATCH_CHUNK;
+        const BTKey *ck = keys + base;
+        BTPayload   *cv = out + base;
+        hc_hot_lock(idx);   // the promoter waits for the chunk
+
+        if (idx->hot_map) {
+            for (size_t j = 0; j < m; j++) hotmap_prefetch(idx->hot_map, ck[j]);
+            for (size_t j = 0; j < m; j++)
+                cv[j] = hotmap_get(idx->hot_map, ck[j], &st->hot_node_visits);
+        } else if (idx->hot_snap) {
+            for (size_t j = 0; j < m; j++)
+                cv[j] = eytz_get(idx->hot_snap, ck[j], &st->hot_node_visits);
+        } else {
+            BTStats hot_s = {0};
+            bt_search_batch(idx->hot, ck, m, cv, &hot_s);
+            st->hot_node_visits += hot_s.node_visits;
+        }
+
+        size_t nmiss = 0;
+        for (size_t j = 0; j < m; j++) {
+            if (cv[j] != NULL || hc_filter_rejects(idx, ck[j])) continue;
+            miss_keys[nmiss] = ck[j];
+            miss_pos[nmiss++] = j;
+        }
+        BTStats cold_s = {0};
+        uint64_t gen = hc_write_gen(idx);
+        bt_search_batch(idx->cold, miss_keys, nmiss, miss_vals, &cold_s);
+        st->cold_node_visits += cold_s.node_visits;
+
+        size_t next_miss = 0;
+        for (size_t j = 0; j < m; j++) {
+            hc_begin_query(idx);
+            if (next_miss < nmiss && miss_pos[next_miss] == j) {
+                cv[j] = miss_vals[next_miss++];
+                // Earlier keys of the chunk may have changed hot: no hint.
+                hc_cold_result(idx, ck[j], cv[j], gen, NULL);
+            } else if (cv[j] == NULL) {
+                st->not_found_filtered++;
+                hc_cold_result(idx, ck[j], NULL, 0, NULL);
+            } else {
+                hc_hot_hit(idx, ck[j]);
+            }
+        }
+        hc_hot_unlock(idx);
+    }
 }
 
-// Helper for deduped range scan: simple callback wrapper
-typedef struct {
-    BTRangeCallback user_cb;
-    void           *user_arg;
-    int64_t        *seen;     // bitmap-ish: seen[key] = 1 if already emitted (size max_key+1)
-    HCIndex        *idx;
-} HCRangeCtx;
+int hc_delete(HCIndex *idx, BTKey k) {
+    HCStats *st = hc_st(idx);
+    st->deletes++;
+    // Cold first: a promotion that read k from cold before this delete
+    // either lands before the hot erase or finds gen bumped and backs off.
+    int in_cold = bt_delete(idx->cold, k);
+    hc_write_lock(idx);
+    hc_write_invalidate(idx);
+    int in_hot  = hc_hot_erase(idx, k);
+    if (in_hot && idx->evictor) hc_evict_remove(idx->evictor, k);
+    hc_write_unlock(idx);
+    // A sketch cannot forget a single key; its count ages out instead.
+    if (idx->heat_table)
+        hc_heat_table_erase(idx->heat_table, k);
+    else if (idx->hit_score && hc_key_in_domain(idx, k))
+        hc_dense_store(idx, k, 0.0);
+    return in_hot || in_cold;
+}
+
+// ---------------------------------------------------------------------------
+// Cursors. In merged mode each tier's cursor is kept next to the current
+// key; a step moves each one just past it in the step direction and takes
+// the nearer of the two (hot on a tie), so duplicates collapse. A tier
+// cursor that ran off an end is re-seeked from the current key.
+
+// Point the tier cursors at this cursor's own counters; the struct may
+// have been copied since the seek.
+static void hc_cursor_bind(HCCursor *c) {
+    c->hot.stats = &c->hot_s;
+    c->cold.stats = &c->cold_s;
+}
+
+// Fold the counted node visits into the index stats.
+static void hc_cursor_flush(HCCursor *c) {
+    c->idx->stats.hot_node_visits  += c->hot_s.node_visits;
+    c->idx->stats.cold_node_visits += c->cold_s.node_visits;
+    c->hot_s.node_visits = c->cold_s.node_visits = 0;
+}
 
-static void hc_range_cb_hot(BTKey k, BTPayload v, void *arg) {
-    HCRangeCtx *ctx = (HCRangeCtx*)arg;
-    if (k < 0 || k > ctx->idx->max_key) return;
-    if (!ctx->seen[k]) {
-        ctx->seen[k] = 1;
-        ctx->user_cb(k, v, ctx->user_arg);
+// Set the current entry from the tier cursors. dir > 0 takes the smaller
+// key, dir < 0 the larger.
+static void hc_cursor_pick(HCCursor *c, int dir) {
+    int cv = bt_cursor_valid(&c->cold);
+    int hv = c->merged && bt_cursor_valid(&c->hot);
+    c->valid = hv || cv;
+    if (!c->valid) return;
+
+    BTCursor *src;
+    if (!cv) src = &c->hot;
+    else if (!hv) src = &c->cold;
+    else {
+        BTKey hk = bt_cursor_key(&c->hot), ck = bt_cursor_key(&c->cold);
+        src = (hk == ck || (dir > 0 ? hk < ck : hk > ck)) ? &c->hot : &c->cold;
     }
+    c->key = bt_cursor_key(src);
+    c->value = bt_cursor_value(src);
 }
 
-static void hc_range_cb_cold(BTKey k, BTPayload v, void *arg) {
-    HCRangeCtx *ctx = (HCRangeCtx*)arg;
-    if (k < 0 || k > ctx->idx->max_key) return;
-    if (!ctx->seen[k]) {
-        ctx->seen[k] = 1;
-        ctx->user_cb(k, v, ctx->user_arg);
+void hc_cursor_seek(HCCursor *c, HCIndex *idx, BTKey k) {
+    c->idx = idx;
+    c->merged = !idx->params.inclusive;
+    c->hot_s.node_visits = c->cold_s.node_visits = 0;
+    bt_cursor_seek(&c->cold, idx->cold, k, &c->cold_s);
+    if (c->merged) bt_cursor_seek(&c->hot, idx->hot, k, &c->hot_s);
+    hc_cursor_pick(c, 1);
+    hc_cursor_flush(c);
+}
+
+void hc_cursor_first(HCCursor *c, HCIndex *idx) {
+    hc_cursor_seek(c, idx, INT64_MIN);
+}
+
+void hc_cursor_last(HCCursor *c, HCIndex *idx) {
+    c->idx = idx;
+    c->merged = !idx->params.inclusive;
+    c->hot_s.node_visits = c->cold_s.node_visits = 0;
+    bt_cursor_last(&c->cold, idx->cold, &c->cold_s);
+    if (c->merged) bt_cursor_last(&c->hot, idx->hot, &c->hot_s);
+    hc_cursor_pick(c, -1);
+    hc_cursor_flush(c);
+}
+
+int hc_cursor_valid(const HCCursor *c) {
+    return c->valid;
+}
+
+BTKey hc_cursor_key(const HCCursor *c) {
+    return c->key;
+}
+
+BTPayload hc_cursor_value(const HCCursor *c) {
+    return c->value;
+}
+
+// Move t to the first key > cur.
+static void hc_tier_after(BTCursor *t, BTree *tree, BTKey cur) {
+    if (!bt_cursor_valid(t)) {
+        bt_cursor_seek(t, tree, cur, t->stats);
     }
+    while (bt_cursor_valid(t) && bt_cursor_key(t) <= cur) bt_cursor_next(t);
 }
 
-void hc_range_search(HCIndex *idx, BTKey lo, BTKey hi,
-                     BTRangeCallback cb, void *arg) {
-    HCRangeCtx ctx;
-    ctx.user_cb = cb;
-    ctx.user_arg = arg;
-    ctx.idx = idx;
-    ctx.seen = (int64_t*)calloc((size_t)(idx->max_key + 1), sizeof(int64_t));
+// Move t to the last key < cur.
+static void hc_tier_before(BTCursor *t, BTree *tree, BTKey cur) {
+    if (!bt_cursor_valid(t)) {
+        bt_cursor_seek(t, tree, cur, t->stats);
+        if (!bt_cursor_valid(t)) bt_cursor_last(t, tree, t->stats);
+    }
+    while (bt_cursor_valid(t) && bt_cursor_key(t) >= cur) bt_cursor_prev(t);
+}
 
-    BTStats hot_s = {0}, cold_s = {0};
-    bt_range_search(idx->hot, lo, hi, hc_range_cb_hot, &ctx, &hot_s);
-    bt_range_search(idx->cold, lo, hi, hc_range_cb_cold, &ctx, &cold_s);
+void hc_cursor_next(HCCursor *c) {
+    if (!c->valid) return;
+    hc_cursor_bind(c);
+    if (c->merged) {
+        hc_tier_after(&c->hot, c->idx->hot, c->key);
+        hc_tier_after(&c->cold, c->idx->cold, c->key);
+    } else {
+        bt_cursor_next(&c->cold);
+    }
+    hc_cursor_pick(c, 1);
+    hc_cursor_flush(c);
+}
 
-    idx->stats.hot_node_visits  += hot_s.node_visits;
-    idx->stats.cold_node_visits += cold_s.node_visits;
+void hc_cursor_prev(HCCursor *c) {
+    if (!c->valid) return;
+    hc_cursor_bind(c);
+    if (c->merged) {
+        hc_tier_before(&c->hot, c->idx->hot, c->key);
+        hc_tier_before(&c->cold, c->idx->cold, c->key);
+    } else {
+        bt_cursor_prev(&c->cold);
+    }
+    hc_cursor_pick(c, -1);
+    hc_cursor_flush(c);
+}
 
-    free(ctx.seen);
+// Range scan. An inclusive hot tier only holds copies of cold keys, so
+// cold alone answers the query. Otherwise the tiers are merged by an
+// HCCursor. Either way the cost depends on the range, not the key domain,
+// and nothing is allocated.
+void hc_range_search(HCIndex *idx, BTKey lo, BTKey hi,
+                     BTRangeCallback cb, void *arg) {
+    if (idx->params.inclusive) {
+        BTStats cold_s = {0};
+        bt_range_search(idx->cold, lo, hi, cb, arg, &cold_s);
+        idx->stats.cold_node_visits += cold_s.node_visits;
+        return;
+    }
+
+    HCCursor c;
+    for (hc_cursor_seek(&c, idx, lo); hc_cursor_valid(&c) && hc_cursor_key(&c) <= hi;
+         hc_cursor_next(&c))
+        cb(hc_cursor_key(&c), hc_cursor_value(&c), arg);
 }
 
 HCStats hc_get_stats(HCIndex *idx) {
+    hc_hot_lock(idx);
     HCStats s = idx->stats;
-    s.hot_keys  = bt_count_keys(idx->hot);
+    if (idx->tstats) {
+        int n = atomic_load(&hc_thread_count);
+        for (int i = 0; i < n && i < HC_MAX_THREADS; i++) hc_stats_add(&s, &idx->tstats[i].s);
+    }
+    s.hot_keys  = hc_hot_count(idx);
+    s.hot_rebuilds = idx->hot_snap ? (long)eytz_rebuilds(idx->hot_snap) : 0;
+    hc_hot_unlock(idx);
     s.cold_keys = bt_count_keys(idx->cold);
+    s.olc_restarts = bt_olc_restarts(idx->hot) + bt_olc_restarts(idx->cold);
+    if (idx->sketch) {
+        s.heat_bytes = cms_bytes(idx->sketch);
+    } else if (idx->heat_table) {
+        s.heat_bytes = (idx->heat_table->mask + 1) * sizeof(HCHeatEntry);
+    } else {
+        size_t n = (size_t)(idx->max_key + 1);
+        s.heat_bytes = n * sizeof(double) + (idx->last_epoch ? n * sizeof(uint32_t) : 0);
+    }
+    s.filter_bytes = idx->cold_filter ? bloom_bytes(idx->cold_filter) : 0;
     return s;
 }
@@ -3,13 +3,98 @@
 #define HCTREE_H
 
 #include "btree.h"
+#include "cmsketch.h"
+#include "bloom.h"
+#include "hotmap.h"
+#include "eytzinger.h"
 
-// Parameters controlling hot/cold behavior.
+// What to do when a key crosses the threshold but the hot tier is full.
+typedef enum {
+    HC_EVICT_NONE = 0,  // refuse the promotion (hot tier freezes at capacity)
+    HC_EVICT_CLOCK,     // second chance: demote the first resident not hit
+                        // since the clock hand last passed it
+    HC_EVICT_LRU,       // approximate LRU: demote the least recently hit of
+                        // a few randomly sampled residents
+    HC_EVICT_SCORE      // min-heap on hit score: demote the lowest-scored
+                        // resident, only if the candidate scores higher
+} HCEvictPolicy;
+
+// How hit scores age.
+typedef enum {
+    HC_EPOCH_NONE = 0,  // score = decay_alpha * score + 1 on each access only
+    HC_EPOCH_QUERIES,   // epochs of epoch_length queries (index-wide)
+    HC_EPOCH_SECONDS    // epochs of epoch_length seconds (CLOCK_MONOTONIC)
+} HCEpochMode;
+
+// Where per-key hit scores live.
+typedef enum {
+    HC_HEAT_DENSE = 0,  // double per possible key: array[max_key+1]
+    HC_HEAT_SKETCH,     // Count-Min Sketch (TinyLFU style); the score is the
+                        // estimated hit count, aged by periodic halving
+                        // (decay_alpha and epoch_mode do not apply)
+    HC_HEAT_TABLE       // open-addressing table with an entry per key that
+                        // has been hit; exact scores, any int64 key
+} HCHeatBackend;
+
+// What holds the hot tier. HASH and EYTZINGER need inclusive mode: range
+// scans are served by cold.
+typedef enum {
+    HC_HOT_TREE = 0,    // a BTree (engine chosen by hot_variant)
+    HC_HOT_HASH,        // a Swiss-table style hash map: a hot hit costs
+                        // about one cache miss
+    HC_HOT_EYTZINGER    // immutable Eytzinger-ordered snapshot plus a delta
+                        // buffer, rebuilt every hot_rebuild_every promotions
+} HCHotTier;
+
+// max_key for hc_create: keys may be any int64_t. Requires a heat backend
+// other than HC_HEAT_DENSE.
+#define HC_KEY_UNBOUNDED ((int64_t)-1)
+
+// Parameters controlling hot/cold behavior. Zero-initialize and set the
+// fields you need; zero selects the default for every optional field.
 typedef struct {
     double decay_alpha;     // e.g., 0.9
     double hot_threshold;   // e.g., 8.0
     double max_hot_fraction;// e.g., 0.10 (10% of keys)
     int    inclusive;       // 1 = hot is a cache (no deletes in cold)
+    HCEvictPolicy evict_policy; // default HC_EVICT_NONE
+
+    // With an epoch mode, decay_alpha is applied once per elapsed epoch
+    // instead of once per access: on a touch the score is aged lazily by
+    // decay_alpha^(epochs since its last touch), then incremented by 1.
+    HCEpochMode epoch_mode;     // default HC_EPOCH_NONE
+    double      epoch_length;   // queries or seconds per epoch
+
+    HCHeatBackend heat_backend;   // default HC_HEAT_DENSE
+    size_t        sketch_counters;// HC_HEAT_SKETCH size; 0 = 8 per hot-tier slot
+    size_t        sketch_sample;  // increments between halvings; 0 = sketch_counters
+
+    HCHotTier hot_tier;         // default HC_HOT_TREE
+    size_t    hot_rebuild_every;// HC_HOT_EYTZINGER delta size; 0 = 64
+    BTVariant hot_variant;      // tree engine per tier; default BT_VARIANT_BTREE
+    BTVariant cold_variant;
+
+    // Bits per cold key of a blocked Bloom filter consulted before every
+    // cold lookup, so a miss skips the cold descent; 0 = no filter.
+    double cold_filter_bits;
+
+    // Hand promotions to a background thread (inclusive mode only): the
+    // query thread enqueues candidates into a bounded lock-free ring and
+    // the promoter applies them in deduplicated batches. A lookup that
+    // finds the hot tier busy with a batch goes straight to cold.
+    int    async_promote;
+    size_t promote_queue;   // ring capacity, rounded up to a power of two;
+                            // 0 = 4096
+
+    // Thread-safe point operations: hc_search, hc_search_batch, hc_insert,
+    // hc_delete and hc_get_stats may be called from any number of threads
+    // once the index is built. Both trees use optimistic lock coupling (see
+    // bt_make_concurrent), counters are kept per thread, and dense hit
+    // scores are updated with relaxed atomics. Needs inclusive mode, a tree
+    // hot tier and the dense heat backend, and excludes epochs, eviction,
+    // the cold filter and async promotion. Range scans and cursors still
+    // need writers quiesced.
+    int    concurrent;
 } HCParams;
 
 // Statistics for evaluation.
@@ -18,39 +103,138 @@ typedef struct {
     long hot_hits;
     long cold_hits;
     long not_found;
+    long not_found_filtered;  // misses answered by the cold filter
+    long deletes;
+    long promotions;
+    long demotions;     // hot residents evicted to admit a hotter key
+    long hot_rebuilds;  // HC_HOT_EYTZINGER snapshot rebuilds
+    long promote_dropped;   // async: candidates lost to a full queue
+    long hot_bypassed;      // async: lookups that skipped a busy hot tier
+    long olc_restarts;      // concurrent: reader restarts in both trees
 
-    long hot_node_visits;
+    long hot_node_visits;   // HC_HOT_HASH: probe groups inspected;
+                            // HC_HOT_EYTZINGER: snapshot + delta searches
     long cold_node_visits;
 
     size_t hot_keys;
     size_t cold_keys;
+    size_t heat_bytes;  // memory held by hit-score state
+    size_t filter_bytes;// memory held by the cold filter
 } HCStats;
 
+typedef struct HCEvictor HCEvictor;
+typedef struct HCHeatTable HCHeatTable;
+typedef struct HCPromoter HCPromoter;
+typedef struct HCThreadStats HCThreadStats;
+typedef struct HCWriteLatch HCWriteLatch;
+
 typedef struct {
-    BTree  *hot;
+    BTree  *hot;         // NULL with HC_HOT_HASH
+    HotMap *hot_map;     // HC_HOT_HASH
+    EytzSet *hot_snap;   // HC_HOT_EYTZINGER
     BTree  *cold;
 
-    int64_t max_key;     // keys ∈ [0, max_key]
-    double *hit_score;   // array[max_key+1]
+    int64_t max_key;     // keys ∈ [0, max_key], or HC_KEY_UNBOUNDED
+    double *hit_score;   // array[max_key+1] (HC_HEAT_DENSE)
+    CMSketch *sketch;    // HC_HEAT_SKETCH
+    HCHeatTable *heat_table; // HC_HEAT_TABLE
+    uint32_t *last_epoch;// array[max_key+1]: epoch of last touch (epoch modes)
+    uint32_t  epoch;     // current epoch
+    double    epoch_t0;  // HC_EPOCH_SECONDS: clock at epoch 0
+
+    HCEvictor *evictor; // hot-tier residency tracking (NULL for HC_EVICT_NONE)
+    BloomFilter *cold_filter; // keys of cold (NULL without cold_filter_bits)
+    HCPromoter *promoter;     // background promotion (NULL unless async_promote)
+    HCThreadStats *tstats;    // per-thread counters (NULL unless concurrent)
+    HCWriteLatch  *latch;     // hot-tier write latch (NULL unless concurrent)
 
     HCParams params;
-    HCStats  stats;
+    HCStats  stats;     // read it through hc_get_stats: concurrent mode
+                        // keeps most counters per thread
 } HCIndex;
 
+// Returns NULL if max_key is HC_KEY_UNBOUNDED with the dense heat backend,
+// or if the parameters combine options that need inclusive mode without it.
 HCIndex* hc_create(int64_t max_key, int btree_degree, HCParams params);
 void     hc_free(HCIndex *idx);
 
-// Build index: insert into COLD only (hot starts empty).
+// With async_promote: wait until every queued promotion candidate has been
+// applied (or discarded). No-op otherwise.
+void     hc_sync(HCIndex *idx);
+
+// Insert or update k in COLD (hot starts empty). An update also refreshes
+// the payload of a hot copy.
 void     hc_insert(HCIndex *idx, BTKey k, BTPayload v);
 
+// Bulk build: load n strictly ascending keys into COLD with bt_bulk_load.
+// Cold must be empty. Returns 1 on success, 0 on rejection.
+int      hc_bulk_load(HCIndex *idx, const BTKey *keys, const BTPayload *values,
+                      size_t n, double fill_factor);
+
 // Point lookup: hot first, then cold if miss.
 BTPayload hc_search(HCIndex *idx, BTKey k);
 
-// Range search: returns all keys in [lo, hi], hot + cold (dedup by key).
+// Look up keys[0..n) into out[] with group-prefetched descents of each
+// tier (see bt_search_batch). Payloads and counters match n hc_search
+// calls, except that keys are processed in chunks of 256 and a promotion
+// only serves hot hits from the next chunk on.
+void      hc_search_batch(HCIndex *idx, const BTKey *keys, size_t n, BTPayload *out);
+
+// Delete: remove k from both tiers and reset its hit score.
+// Returns 1 if the key was present in either tier.
+int      hc_delete(HCIndex *idx, BTKey k);
+
+// Range search: calls cb for every key in [lo, hi] once, in ascending order
+// (hot + cold, dedup by key). Allocation-free.
 void     hc_range_search(HCIndex *idx, BTKey lo, BTKey hi,
                          BTRangeCallback cb, void *arg);
 
+// Ordered cursor over the index: each key once, ascending, with the hot
+// copy preferred. With an inclusive hot tier it walks cold alone;
+// otherwise it merges cursors over both tiers. Node visits are added to
+// the index stats. Lives on the caller's stack; the index must not be
+// modified while it is in use.
+typedef struct {
+    HCIndex  *idx;
+    BTCursor  hot, cold;
+    BTStats   hot_s, cold_s;
+    int       merged;   // 0 = cold only
+    int       valid;
+    BTKey     key;
+    BTPayload value;
+} HCCursor;
+
+void      hc_cursor_seek(HCCursor *c, HCIndex *idx, BTKey k);   // first key >= k
+void      hc_cursor_first(HCCursor *c, HCIndex *idx);
+void      hc_cursor_last(HCCursor *c, HCIndex *idx);
+int       hc_cursor_valid(const HCCursor *c);
+BTKey     hc_cursor_key(const HCCursor *c);
+BTPayload hc_cursor_value(const HCCursor *c);
+void      hc_cursor_next(HCCursor *c);
+void      hc_cursor_prev(HCCursor *c);
+
+// How the calling thread's most recent lookup (hc_search, or the last key
+// of hc_search_batch) was answered. PROMOTED is a cold hit that promoted
+// its key, or with async_promote queued it.
+typedef enum {
+    HC_OUTCOME_HOT_HIT = 0,
+    HC_OUTCOME_COLD_HIT,
+    HC_OUTCOME_MISS,
+    HC_OUTCOME_PROMOTED
+} HCOutcome;
+
+HCOutcome hc_last_outcome(void);
+
 // Get stats snapshot.
 HCStats  hc_get_stats(HCIndex *idx);
+// Hot plus cold node visits counted for the calling thread so far; cheap
+// enough to read around every operation.
+long     hc_node_visits(HCIndex *idx);
+// dst += src, field by field.
+void     hc_stats_add(HCStats *dst, const HCStats *src);
+
+const char* hc_evict_policy_name(HCEvictPolicy p);
+const char* hc_hot_tier_name(HCHotTier tier);
+const char* hc_heat_backend_name(HCHeatBackend b);
 
 #endif // HCTREE_H
@@ -0,0 +1,169 @@
+// hotmap.c
+#include "hotmap.h"
+#include "hash64.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define HM_HAVE_SSE2 1
+#endif
+
+#define HM_GROUP   16
+#define HM_EMPTY   ((uint8_t)0x80)
+#define HM_DELETED ((uint8_t)0xFE)   // full slots hold a tag in 0..127
+
+struct HotMap {
+    uint8_t   *ctrl;     // control byte per slot, 64-byte aligned
+    BTKey     *keys;
+    BTPayload *vals;
+    size_t     nslots;   // power of two, multiple of HM_GROUP
+    size_t     count;    // full slots
+    size_t     deleted;  // tombstones
+};
+
+// Bit i set where ctrl[i] == b, over one group.
+static unsigned hm_match(const uint8_t *ctrl, uint8_t b) {
+#ifdef HM_HAVE_SSE2
+    __m128i c = _mm_loadu_si128((const __m128i*)ctrl);
+    return (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_set1_epi8((char)b)));
+#else
+    unsigned m = 0;
+    for (int i = 0; i < HM_GROUP; i++) m |= (unsigned)(ctrl[i] == b) << i;
+    return m;
+#endif
+}
+
+// Bit i set where slot i is empty or deleted (high bit of ctrl).
+static unsigned hm_match_free(const uint8_t *ctrl) {
+#ifdef HM_HAVE_SSE2
+    return (unsigned)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)ctrl));
+#else
+    unsigned m = 0;
+    for (int i = 0; i < HM_GROUP; i++) m |= (unsigned)(ctrl[i] >> 7) << i;
+    return m;
+#endif
+}
+
+static void hm_alloc(HotMap *m, size_t nslots) {
+    m->nslots = nslots;
+    m->ctrl = (uint8_t*)aligned_alloc(64, nslots < 64 ? 64 : nslots);
+    memset(m->ctrl, HM_EMPTY, nslots);
+    m->keys = (BTKey*)malloc(sizeof(BTKey) * nslots);
+    m->vals = (BTPayload*)malloc(sizeof(BTPayload) * nslots);
+    m->count = 0;
+    m->deleted = 0;
+}
+
+HotMap* hotmap_create(size_t capacity) {
+    HotMap *m = (HotMap*)malloc(sizeof(HotMap));
+    size_t n = HM_GROUP;
+    while (n * 7 / 8 < capacity) n *= 2;
+    hm_alloc(m, n);
+    return m;
+}
+
+void hotmap_free(HotMap *m) {
+    if (!m) return;
+    free(m->ctrl);
+    free(m->keys);
+    free(m->vals);
+    free(m);
+}
+
+// Slot holding key, or -1. Probe group sequence: g, g+1, g+3, g+6, ...
+static long hm_find(const HotMap *m, BTKey key, uint64_t h, long *probes) {
+    size_t gmask = m->nslots / HM_GROUP - 1;
+    size_t g = (size_t)(h >> 7) & gmask;
+    uint8_t tag = (uint8_t)(h & 0x7f);
+    for (size_t step = 1;; step++) {
+        const uint8_t *ctrl = m->ctrl + g * HM_GROUP;
+        if (probes) (*probes)++;
+        for (unsigned bits = hm_match(ctrl, tag); bits; bits &= bits - 1) {
+            size_t s = g * HM_GROUP + (size_t)__builtin_ctz(bits);
+            if (m->keys[s] == key) return (long)s;
+        }
+        if (hm_match(ctrl, HM_EMPTY)) return -1;
+        g = (g + step) & gmask;
+    }
+}
+
+BTPayload hotmap_get(const HotMap *m, BTKey key, long *probes) {
+    long s = hm_find(m, key, mix64((uint64_t)key), probes);
+    return s < 0 ? NULL : m->vals[s];
+}
+
+void hotmap_prefetch(const HotMap *m, BTKey key) {
+    uint64_t h = mix64((uint64_t)key);
+    size_t g = (size_t)(h >> 7) & (m->nslots / HM_GROUP - 1);
+    __builtin_prefetch(m->ctrl + g * HM_GROUP, 0, 3);
+    __builtin_prefetch(m->keys + g * HM_GROUP, 0, 3);
+}
+
+// Place a key known to be absent in the first free slot of its probe.
+static void hm_place(HotMap *m, BTKey key, BTPayload value, uint64_t h) {
+    size_t gmask = m->nslots / HM_GROUP - 1;
+    size_t g = (size_t)(h >> 7) & gmask;
+    for (size_t step = 1;; step++) {
+        unsigned free_bits = hm_match_free(m->ctrl + g * HM_GROUP);
+        if (free_bits) {
+            size_t s = g * HM_GROUP + (size_t)__builtin_ctz(free_bits);
+            if (m->ctrl[s] == HM_DELETED) m->deleted--;
+            m->ctrl[s] = (uint8_t)(h & 0x7f);
+            m->keys[s] = key;
+            m->vals[s] = value;
+            m->count++;
+            return;
+        }
+        g = (g + step) & gmask;
+    }
+}
+
+// Rehash into nslots slots, dropping tombstones.
+static void hm_rehash(HotMap *m, size_t nslots) {
+    HotMap old = *m;
+    hm_alloc(m, nslots);
+    for (size_t s = 0; s < old.nslots; s++)
+        if (!(old.ctrl[s] & 0x80))
+            hm_place(m, old.keys[s], old.vals[s], mix64((uint64_t)old.keys[s]));
+    free(old.ctrl);
+    free(old.keys);
+    free(old.vals);
+}
+
+void hotmap_put(HotMap *m, BTKey key, BTPayload value) {
+    uint64_t h = mix64((uint64_t)key);
+    long s = hm_find(m, key, h, NULL);
+    if (s >= 0) {
+        m->vals[s] = value;
+        return;
+    }
+    // Keep full + deleted slots under 7/8; grow only if live keys need it.
+    if ((m->count + m->deleted + 1) * 8 > m->nslots * 7)
+        hm_rehash(m, (m->count + 1) * 2 > m->nslots ? m->nslots * 2 : m->nslots);
+    hm_place(m, key, value, h);
+}
+
+int hotmap_erase(HotMap *m, BTKey key) {
+    long s = hm_find(m, key, mix64((uint64_t)key), NULL);
+    if (s < 0) return 0;
+    // Lookups stop at a group with an empty slot, so a slot in such a group
+    // can go straight back to empty; otherwise it must stay a tombstone.
+    const uint8_t *group = m->ctrl + (size_t)s / HM_GROUP * HM_GROUP;
+    if (hm_match(group, HM_EMPTY)) {
+        m->ctrl[s] = HM_EMPTY;
+    } else {
+        m->ctrl[s] = HM_DELETED;
+        m->deleted++;
+    }
+    m->count--;
+    return 1;
+}
+
+size_t hotmap_count(const HotMap *m) {
+    return m->count;
+}
+
+size_t hotmap_bytes(const HotMap *m) {
+    return m->nslots * (1 + sizeof(BTKey) + sizeof(BTPayload));
+}
@@ -0,0 +1,38 @@
+// hotmap.h
+#ifndef HOTMAP_H
+#define HOTMAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "btree.h"
+
+// Open-addressing key -> payload map in the Swiss-table style, used as a
+// point-lookup hot tier. Slots come in groups of 16 with one control byte
+// each (a 7-bit hash tag, or empty/deleted); a probe compares all 16 tags
+// of a group at once (SSE2 where available) and only then touches keys.
+// Groups are probed quadratically; a lookup stops at the first group that
+// has an empty slot, so it usually costs one control line and one key line.
+
+typedef struct HotMap HotMap;
+
+// Room for about `capacity` keys before the first resize.
+HotMap*   hotmap_create(size_t capacity);
+void      hotmap_free(HotMap *m);
+
+// Payload of key, or NULL. If probes != NULL it accumulates the number of
+// groups inspected.
+BTPayload hotmap_get(const HotMap *m, BTKey key, long *probes);
+
+// Insert or overwrite.
+void      hotmap_put(HotMap *m, BTKey key, BTPayload value);
+
+// Returns 1 if key was present.
+int       hotmap_erase(HotMap *m, BTKey key);
+
+// Issue a prefetch for the first group key probes.
+void      hotmap_prefetch(const HotMap *m, BTKey key);
+
+size_t    hotmap_count(const HotMap *m);
+size_t    hotmap_bytes(const HotMap *m);
+
+#endif // HOTMAP_H
@@ -0,0 +1,80 @@
+// lathist.c
+#include "lathist.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define LH_SUB_BITS 5
+#define LH_SUB      (1u << LH_SUB_BITS)            // buckets per power of two
+#define LH_BUCKETS  ((64 - LH_SUB_BITS + 1) * LH_SUB)
+
+struct LatHist {
+    uint64_t counts[LH_BUCKETS];
+    uint64_t total;
+    uint64_t max;
+};
+
+// For v in [2^e, 2^(e+1)) with e >= LH_SUB_BITS the top LH_SUB_BITS + 1
+// bits of v pick the bucket; smaller values index directly.
+static size_t lh_index(uint64_t v) {
+    if (v < 2 * LH_SUB) return (size_t)v;
+    int shift = 63 - __builtin_clzll(v) - LH_SUB_BITS;
+    return (size_t)shift * LH_SUB + (size_t)(v >> shift);
+}
+
+// Largest value that maps to bucket i.
+static uint64_t lh_upper(size_t i) {
+    if (i < 2 * LH_SUB) return (uint64_t)i;
+    size_t shift = i / LH_SUB - 1;
+    uint64_t q = (uint64_t)(i - shift * LH_SUB);
+    return ((q + 1) << shift) - 1;
+}
+
+LatHist* lh_create(void) {
+    return (LatHist*)calloc(1, sizeof(LatHist));
+}
+
+void lh_free(LatHist *h) {
+    free(h);
+}
+
+void lh_reset(LatHist *h) {
+    memset(h, 0, sizeof(LatHist));
+}
+
+void lh_record(LatHist *h, uint64_t value) {
+    h->counts[lh_index(value)]++;
+    h->total++;
+    if (value > h->max) h->max = value;
+}
+
+void lh_merge(LatHist *dst, const LatHist *src) {
+    for (size_t i = 0; i < LH_BUCKETS; i++) dst->counts[i] += src->counts[i];
+    dst->total += src->total;
+    if (src->max > dst->max) dst->max = src->max;
+}
+
+uint64_t lh_count(const LatHist *h) {
+    return h->total;
+}
+
+uint64_t lh_max(const LatHist *h) {
+    return h->max;
+}
+
+uint64_t lh_percentile(const LatHist *h, double p) {
+    if (h->total == 0) return 0;
+    if (p < 0.0) p = 0.0;
+    if (p > 100.0) p = 100.0;
+    // Rank of the value sought, 1-based.
+    uint64_t rank = (uint64_t)(p / 100.0 * (double)h->total + 0.5);
+    if (rank < 1) rank = 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < LH_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen >= rank) {
+            uint64_t u = lh_upper(i);
+            return u < h->max ? u : h->max;
+        }
+    }
+    return h->max;
+}
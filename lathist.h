@@ -0,0 +1,31 @@
+// lathist.h
+#ifndef LATHIST_H
+#define LATHIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Log-linear latency histogram in the HDR style: values below 32 get one
+// bucket each, and every power-of-two range above that is split into 32
+// equal buckets, so any recorded value is known to within ~3% across the
+// full uint64_t range in a fixed 15 KiB of counters.
+
+typedef struct LatHist LatHist;
+
+LatHist* lh_create(void);
+void     lh_free(LatHist *h);
+void     lh_reset(LatHist *h);
+
+void     lh_record(LatHist *h, uint64_t value);
+
+// dst += src.
+void     lh_merge(LatHist *dst, const LatHist *src);
+
+uint64_t lh_count(const LatHist *h);
+uint64_t lh_max(const LatHist *h);
+
+// Smallest bucket upper bound at or below which p percent (0..100) of the
+// recorded values fall; 0 for an empty histogram.
+uint64_t lh_percentile(const LatHist *h, double p);
+
+#endif // LATHIST_H
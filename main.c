@@ -1,4 +1,5 @@
 // main.c
+#define _GNU_SOURCE   // pthread_setaffinity_np, pthread barriers
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -7,63 +8,276 @@
 #include <math.h>
 #include <inttypes.h>
 #include <stdbool.h>
+#include <ctype.h>
+#include <pthread.h>
+#include <sched.h>
 
 #include "btree.h"
 #include "hctree.h"
+#include "hcshard.h"
+#include "lathist.h"
+#include "hash64.h"
 
-// Simple payload: just store the key as a pointer-sized value.
+// Simple payload: the key + 1 as a pointer-sized value. The offset keeps
+// key 0's payload non-NULL, since a NULL payload reads as "not found".
 static void* make_payload(int64_t k) {
-    return (void*)(intptr_t)k;
+    return (void*)(intptr_t)(k + 1);
 }
 
-// Uniform random in [0, n-1]
+// Workload PRNG: xoshiro256** seeded through splitmix64, so every seed,
+// including 0, gives a well-mixed state. Much cheaper than rand() and
+// with 64 random bits per call.
+static uint64_t rng_state[4];
+
+static uint64_t splitmix64(uint64_t *x) {
+    return mix64(*x += 0x9e3779b97f4a7c15ULL);
+}
+
+static void rng_seed(uint64_t seed) {
+    for (int i = 0; i < 4; i++) rng_state[i] = splitmix64(&seed);
+}
+
+static inline uint64_t rotl64(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static uint64_t rng_next(void) {
+    uint64_t *s = rng_state;
+    uint64_t result = rotl64(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl64(s[3], 45);
+    return result;
+}
+
+// Uniform in [0, 1), 53 bits.
+static double rng_double(void) {
+    return (double)(rng_next() >> 11) * 0x1.0p-53;
+}
+
+// Uniform random in [0, n-1] (Lemire's multiply-shift; bias < n / 2^64).
 static int64_t rand_uniform(int64_t n) {
-    return (int64_t)((double)rand() / ((double)RAND_MAX + 1.0) * (double)n);
+    return (int64_t)(((unsigned __int128)rng_next() * (uint64_t)n) >> 64);
 }
 
-// Zipf sampler with precomputed CDF O(log N) sampling.
+// Zipf sampler over ranks 1..N, P(k) ~ k^-s, by rejection-inversion
+// (Hörmann & Derflinger, 1996): invert the integral H of the continuous
+// hat h(x) = x^-s and accept the rounded point unless it falls in the gap
+// between hat and histogram. O(1) memory and expected O(1) time, and the
+// acceptance rate is above 90% for every s > 0.
 typedef struct {
-    double  *cdf; // size N
-    int64_t  N;
-    double   s;
+    int64_t N;
+    double  s;
+    double  h_integral_x1;   // H(1.5) - 1
+    double  h_integral_n;    // H(N + 0.5)
+    double  squeeze;         // accept without evaluating H when k - x <= this
 } ZipfGen;
 
+// log1p(x) / x and expm1(x) / x, continuous through x = 0 (s = 1).
+static double zipf_helper1(double x) {
+    return fabs(x) > 1e-8 ? log1p(x) / x : 1.0 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+}
+
+static double zipf_helper2(double x) {
+    return fabs(x) > 1e-8 ? expm1(x) / x : 1.0 + x * 0.5 * (1.0 + x * (1.0 / 3.0) * (1.0 + 0.25 * x));
+}
+
+static double zipf_h(const ZipfGen *z, double x) {
+    return exp(-z->s * log(x));
+}
+
+static double zipf_H(const ZipfGen *z, double x) {
+    double lx = log(x);
+    return zipf_helper2((1.0 - z->s) * lx) * lx;
+}
+
+static double zipf_H_inv(const ZipfGen *z, double x) {
+    double t = x * (1.0 - z->s);
+    if (t < -1.0) t = -1.0;   // rounding guard at the top of the range
+    return exp(zipf_helper1(t) * x);
+}
+
 static ZipfGen* zipf_create(int64_t N, double s) {
     ZipfGen *z = (ZipfGen*)malloc(sizeof(ZipfGen));
     z->N = N;
     z->s = s;
-    z->cdf = (double*)malloc(sizeof(double) * N);
-
-    double sum = 0.0;
-    for (int64_t k = 1; k <= N; k++) {
-        sum += 1.0 / pow((double)k, s);
-    }
-
-    double cumsum = 0.0;
-    for (int64_t k = 1; k <= N; k++) {
-        cumsum += 1.0 / pow((double)k, s) / sum;
-        z->cdf[k-1] = cumsum;
-    }
+    z->h_integral_x1 = zipf_H(z, 1.5) - 1.0;
+    z->h_integral_n = zipf_H(z, (double)N + 0.5);
+    z->squeeze = 2.0 - zipf_H_inv(z, zipf_H(z, 2.5) - zipf_h(z, 2.0));
     return z;
 }
 
 static void zipf_free(ZipfGen *z) {
-    if (!z) return;
-    free(z->cdf);
     free(z);
 }
 
 static int64_t zipf_sample(ZipfGen *z) {
-    double u = (double)rand() / ((double)RAND_MAX + 1.0);
-    // binary search in cdf
-    int64_t lo = 0, hi = z->N - 1, mid;
-    while (lo < hi) {
-        mid = (lo + hi) / 2;
-        if (u <= z->cdf[mid]) hi = mid;
-        else lo = mid + 1;
+    for (;;) {
+        double u = z->h_integral_n + rng_double() * (z->h_integral_x1 - z->h_integral_n);
+        double x = zipf_H_inv(z, u);
+        int64_t k = (int64_t)(x + 0.5);
+        if (k < 1) k = 1;
+        else if (k > z->N) k = z->N;
+        if ((double)k - x <= z->squeeze || u >= zipf_H(z, (double)k + 0.5) - zipf_h(z, (double)k))
+            return k - 1;   // rank k as key k - 1 in [0, N-1]
+    }
+}
+
+// Key with rank r. Dense keys are 0..nkeys-1; sparse keys scatter the
+// ranks over the whole int64_t range (splitmix64 finalizer, a bijection).
+static int64_t key_of(int64_t r, bool sparse) {
+    if (!sparse) return r;
+    uint64_t x = (uint64_t)r;
+    return (int64_t)splitmix64(&x);
+}
+
+static int cmp_int64(const void *a, const void *b) {
+    int64_t x = *(const int64_t*)a, y = *(const int64_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Next query key from the workload. shift moves the hotspot: zipf rank r
+// maps to key (r + shift) % nkeys. With probability miss_frac the key is
+// instead one that was never inserted (rank in [nkeys, 2*nkeys)).
+static int64_t draw_key(ZipfGen *zg, int64_t nkeys, int64_t shift, bool sparse,
+                        double miss_frac) {
+    if (miss_frac > 0.0 && rng_double() < miss_frac)
+        return key_of(nkeys + rand_uniform(nkeys), sparse);
+    int64_t k = zg ? zipf_sample(zg) : rand_uniform(nkeys);
+    return key_of(shift ? (k + shift) % nkeys : k, sparse);
+}
+
+// --latency: per-operation latency in nanoseconds, one histogram per
+// outcome plus one over all operations. A batch call is timed as a whole
+// and counted as that many operations of its per-key share.
+typedef enum {
+    LAT_HOT = 0,
+    LAT_COLD,
+    LAT_MISS,
+    LAT_PROMOTE,
+    LAT_DELETE,
+    LAT_UPDATE,
+    LAT_INSERT,
+    LAT_SCAN,
+    LAT_RMW,
+    LAT_BATCH,
+    LAT_KINDS
+} LatKind;
+
+static const char *const lat_kind_name[LAT_KINDS] = {
+    "hot hit", "cold hit", "miss", "promotion", "delete", "update", "insert",
+    "scan", "rmw", "batched"
+};
+
+typedef struct {
+    LatHist *h[LAT_KINDS];
+    LatHist *all;
+} LatSet;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static LatSet* lat_create(void) {
+    LatSet *l = (LatSet*)malloc(sizeof(LatSet));
+    for (int i = 0; i < LAT_KINDS; i++) l->h[i] = lh_create();
+    l->all = lh_create();
+    return l;
+}
+
+static void lat_free(LatSet *l) {
+    if (!l) return;
+    for (int i = 0; i < LAT_KINDS; i++) lh_free(l->h[i]);
+    lh_free(l->all);
+    free(l);
+}
+
+static void lat_merge(LatSet *dst, const LatSet *src) {
+    for (int i = 0; i < LAT_KINDS; i++) lh_merge(dst->h[i], src->h[i]);
+    lh_merge(dst->all, src->all);
+}
+
+static void lat_record(LatSet *l, LatKind kind, uint64_t ns) {
+    lh_record(l->h[kind], ns);
+    lh_record(l->all, ns);
+}
+
+static void lat_record_batch(LatSet *l, size_t n, uint64_t ns) {
+    for (size_t j = 0; j < n; j++) lat_record(l, LAT_BATCH, ns / n);
+}
+
+static LatKind lat_kind_of(HCOutcome o) {
+    switch (o) {
+    case HC_OUTCOME_HOT_HIT:  return LAT_HOT;
+    case HC_OUTCOME_COLD_HIT: return LAT_COLD;
+    case HC_OUTCOME_PROMOTED: return LAT_PROMOTE;
+    default:                  return LAT_MISS;
     }
-    // lo is index in [0, N-1], representing rank (1-based)
-    return lo; // treat as key in [0, N-1]
+}
+
+static void print_latency_row(const char *name, const LatHist *h) {
+    printf("  %-10s %10" PRIu64 " %9" PRIu64 " %9" PRIu64 " %9" PRIu64 " %11" PRIu64 "\n",
+           name, lh_count(h), lh_percentile(h, 50.0), lh_percentile(h, 99.0),
+           lh_percentile(h, 99.9), lh_max(h));
+}
+
+static void print_latency(const LatSet *l) {
+    printf("Latency (ns):     %10s %9s %9s %9s %11s\n", "ops", "p50", "p99", "p99.9", "max");
+    for (int i = 0; i < LAT_KINDS; i++) {
+        if (lh_count(l->h[i])) print_latency_row(lat_kind_name[i], l->h[i]);
+    }
+    print_latency_row("all", l->all);
+}
+
+// CSV latency columns: p50, p99 and p99.9 over all operations, then for
+// hot hits, cold hits, misses and promotions; zeros without --latency.
+static void print_latency_csv(const LatSet *l) {
+    const LatHist *cols[] = {
+        l ? l->all : NULL,
+        l ? l->h[LAT_HOT] : NULL,
+        l ? l->h[LAT_COLD] : NULL,
+        l ? l->h[LAT_MISS] : NULL,
+        l ? l->h[LAT_PROMOTE] : NULL,
+    };
+    for (size_t c = 0; c < sizeof(cols) / sizeof(cols[0]); c++) {
+        const LatHist *h = cols[c];
+        printf(",%" PRIu64 ",%" PRIu64 ",%" PRIu64,
+               h ? lh_percentile(h, 50.0) : 0, h ? lh_percentile(h, 99.0) : 0,
+               h ? lh_percentile(h, 99.9) : 0);
+    }
+}
+
+// Baseline --batch: look up the *n pending keys with bt_search_batch and
+// empty the batch. Returns the number of misses.
+static long run_bt_batch(BTree *bt, const BTKey *keys, size_t *n,
+                         BTPayload *out, long *node_visits, LatSet *lat) {
+    if (*n == 0) return 0;
+    BTStats s = {0};
+    long misses = 0;
+    uint64_t ta = lat ? now_ns() : 0;
+    bt_search_batch(bt, keys, *n, out, &s);
+    if (lat) lat_record_batch(lat, *n, now_ns() - ta);
+    *node_visits += s.node_visits;
+    for (size_t j = 0; j < *n; j++)
+        misses += out[j] == NULL;
+    *n = 0;
+    return misses;
+}
+
+// HCIndex --batch: the same for hc_sharded_search_batch.
+static void run_hc_batch(HCShardedIndex *hc, const BTKey *keys, size_t *n,
+                         BTPayload *out, LatSet *lat) {
+    if (*n == 0) return;
+    uint64_t ta = lat ? now_ns() : 0;
+    hc_sharded_search_batch(hc, keys, *n, out);
+    if (lat) lat_record_batch(lat, *n, now_ns() - ta);
+    *n = 0;
 }
 
 // For timing
@@ -73,6 +287,518 @@ static double now_seconds(void) {
     return (double)tv.tv_sec + (double)tv.tv_usec / 1e6;
 }
 
+// --threads: the operations are drawn up front, dealt round-robin into one
+// stream per thread, and replayed between a start and a stop barrier, so
+// the timed region only contains index calls.
+typedef struct {
+    BTKey   *keys;   // lookup key, or the key to delete
+    uint8_t *del;    // 1 = delete keys[i]
+    int64_t  n;
+} OpStream;
+
+typedef struct {
+    const OpStream    *ops;
+    BTree             *bt;    // baseline
+    HCShardedIndex    *hc;    // hctree
+    int64_t            batch;
+    int                cpu;   // -1 = not pinned
+    pthread_barrier_t *start, *stop;
+    double             t0, t1;   // this thread's own first and last op
+    LatSet            *lat;      // --latency, else NULL
+    // Baseline counters (HCIndex keeps its own).
+    long lookups, misses, deletes, node_visits;
+} Worker;
+
+static void* worker_main(void *arg) {
+    Worker *w = (Worker*)arg;
+    if (w->cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(w->cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+    size_t cap = w->batch > 1 ? (size_t)w->batch : 1, nb = 0;
+    BTKey     *bk = (BTKey*)malloc(sizeof(BTKey) * cap);
+    BTPayload *bo = (BTPayload*)malloc(sizeof(BTPayload) * cap);
+    const OpStream *ops = w->ops;
+
+    pthread_barrier_wait(w->start);
+    w->t0 = now_seconds();
+    for (int64_t i = 0; i < ops->n; i++) {
+        BTKey k = ops->keys[i];
+        uint64_t ta;
+        if (ops->del[i]) {
+            if (w->bt) w->misses += run_bt_batch(w->bt, bk, &nb, bo, &w->node_visits, w->lat);
+            else run_hc_batch(w->hc, bk, &nb, bo, w->lat);
+            ta = w->lat ? now_ns() : 0;
+            if (w->bt) {
+                bt_delete(w->bt, k);
+                w->deletes++;
+            } else {
+                (void)hc_sharded_delete(w->hc, k);
+            }
+            if (w->lat) lat_record(w->lat, LAT_DELETE, now_ns() - ta);
+            continue;
+        }
+        if (w->bt) w->lookups++;
+        if (w->batch > 1) {
+            bk[nb++] = k;
+            if (nb < cap) continue;
+            if (w->bt) w->misses += run_bt_batch(w->bt, bk, &nb, bo, &w->node_visits, w->lat);
+            else run_hc_batch(w->hc, bk, &nb, bo, w->lat);
+            continue;
+        }
+        LatKind kind;
+        ta = w->lat ? now_ns() : 0;
+        if (w->bt) {
+            BTStats s = {0};
+            bool miss = bt_search(w->bt, k, &s) == NULL;
+            w->misses += miss;
+            w->node_visits += s.node_visits;
+            kind = miss ? LAT_MISS : LAT_COLD;
+        } else {
+            (void)hc_sharded_search(w->hc, k);
+            kind = lat_kind_of(hc_last_outcome());
+        }
+        if (w->lat) lat_record(w->lat, kind, now_ns() - ta);
+    }
+    if (w->bt) w->misses += run_bt_batch(w->bt, bk, &nb, bo, &w->node_visits, w->lat);
+    else run_hc_batch(w->hc, bk, &nb, bo, w->lat);
+    w->t1 = now_seconds();
+    pthread_barrier_wait(w->stop);
+
+    free(bk);
+    free(bo);
+    return NULL;
+}
+
+// Run n workers released together; returns the wall time from the start
+// barrier to the last worker reaching the stop barrier.
+static double run_workers(Worker *w, int n) {
+    pthread_barrier_t start, stop;
+    pthread_barrier_init(&start, NULL, (unsigned)n + 1);
+    pthread_barrier_init(&stop, NULL, (unsigned)n + 1);
+    pthread_t *tid = (pthread_t*)malloc(sizeof(pthread_t) * (size_t)n);
+    for (int i = 0; i < n; i++) {
+        w[i].start = &start;
+        w[i].stop = &stop;
+        pthread_create(&tid[i], NULL, worker_main, &w[i]);
+    }
+    pthread_barrier_wait(&start);
+    double t0 = now_seconds();
+    pthread_barrier_wait(&stop);
+    double elapsed = now_seconds() - t0;
+    for (int i = 0; i < n; i++) pthread_join(tid[i], NULL);
+    free(tid);
+    pthread_barrier_destroy(&start);
+    pthread_barrier_destroy(&stop);
+    return elapsed;
+}
+
+// CPU for thread i: the (i mod count)-th CPU this process may run on.
+static int pick_cpu(int i) {
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) return -1;
+    int count = CPU_COUNT(&set);
+    if (count <= 0) return -1;
+    int want = i % count;
+    for (int c = 0; c < CPU_SETSIZE; c++) {
+        if (CPU_ISSET(c, &set) && want-- == 0) return c;
+    }
+    return -1;
+}
+
+// Deal nqueries operations round-robin into one stream per thread, drawn
+// exactly as the single-threaded loops draw them.
+static OpStream* make_streams(int threads, int64_t nqueries, ZipfGen *zg, int64_t nkeys,
+                              bool sparse, double miss_frac, double delete_frac,
+                              int64_t shift_every) {
+    OpStream *st = (OpStream*)calloc((size_t)threads, sizeof(OpStream));
+    size_t cap = (size_t)(nqueries / threads + 1);
+    for (int t = 0; t < threads; t++) {
+        st[t].keys = (BTKey*)malloc(sizeof(BTKey) * cap);
+        st[t].del = (uint8_t*)malloc(cap);
+    }
+    int64_t shift = 0;
+    for (int64_t q = 0; q < nqueries; q++) {
+        OpStream *o = &st[q % threads];
+        if (shift_every > 0 && q > 0 && q % shift_every == 0)
+            shift = (shift + nkeys / 3) % nkeys;
+        bool del = delete_frac > 0.0 && rng_double() < delete_frac;
+        o->del[o->n] = del;
+        o->keys[o->n++] = del ? key_of(rand_uniform(nkeys), sparse)
+                              : draw_key(zg, nkeys, shift, sparse, miss_frac);
+    }
+    return st;
+}
+
+static void free_streams(OpStream *st, int threads) {
+    for (int t = 0; t < threads; t++) {
+        free(st[t].keys);
+        free(st[t].del);
+    }
+    free(st);
+}
+
+// Replay the first `threads` streams, one pinned thread each. Stores each
+// thread's own QPS in thread_qps (may be NULL), adds the baseline counters
+// to *sum and, if lat is set, merges every thread's latencies into it.
+// Returns the barrier-to-barrier wall time.
+static double run_streams(const OpStream *st, int threads, BTree *bt, HCShardedIndex *hc,
+                          int64_t batch, double *thread_qps, Worker *sum, LatSet *lat) {
+    Worker *w = (Worker*)calloc((size_t)threads, sizeof(Worker));
+    for (int t = 0; t < threads; t++) {
+        w[t].ops = &st[t];
+        w[t].bt = bt;
+        w[t].hc = hc;
+        w[t].batch = batch;
+        w[t].cpu = pick_cpu(t);
+        w[t].lat = lat ? lat_create() : NULL;
+    }
+    double elapsed = run_workers(w, threads);
+    for (int t = 0; t < threads; t++) {
+        double sec = w[t].t1 - w[t].t0;
+        if (thread_qps) thread_qps[t] = sec > 0.0 ? (double)st[t].n / sec : 0.0;
+        if (sum) {
+            sum->lookups += w[t].lookups;
+            sum->misses += w[t].misses;
+            sum->deletes += w[t].deletes;
+            sum->node_visits += w[t].node_visits;
+        }
+        if (lat) lat_merge(lat, w[t].lat);
+        lat_free(w[t].lat);
+    }
+    free(w);
+    return elapsed;
+}
+
+// Fill an empty index from the sorted build input, by bulk load or one
+// insert per key.
+static void fill_hc(HCShardedIndex *idx, const BTKey *keys, const BTPayload *vals,
+                    int64_t n, bool bulk, double fill) {
+    if (bulk) {
+        hc_sharded_bulk_load(idx, keys, vals, (size_t)n, fill);
+    } else {
+        for (int64_t k = 0; k < n; k++)
+            hc_sharded_insert(idx, keys[k], vals[k]);
+    }
+}
+
+static void fill_bt(BTree *bt, const BTKey *keys, const BTPayload *vals,
+                    int64_t n, bool bulk, double fill) {
+    if (bulk) {
+        bt_bulk_load(bt, keys, vals, (size_t)n, fill);
+    } else {
+        for (int64_t k = 0; k < n; k++)
+            bt_insert(bt, keys[k], vals[k]);
+    }
+}
+
+// Replay stream 0 alone, for the single-thread reference of scaling_eff.
+// Callers pass a freshly built index, identical to the one the threaded
+// run starts from: replaying on the index that run already used would
+// find its deletes done and its hot tier warm.
+static double solo_qps(const OpStream *st, BTree *bt, HCShardedIndex *hc, int64_t batch) {
+    double sec = run_streams(st, 1, bt, hc, batch, NULL, NULL, NULL);
+    return sec > 0.0 ? (double)st[0].n / sec : 0.0;
+}
+
+// Per-thread QPS spread and scaling efficiency: aggregate QPS over threads
+// times the solo QPS. A run without --threads reports its own QPS and 1.
+static void thread_summary(const double *thread_qps, int threads, double qps, double ref_qps,
+                           double *qps_min, double *qps_max, double *eff) {
+    *qps_min = *qps_max = qps;
+    *eff = 1.0;
+    if (threads <= 0) return;
+    *qps_min = *qps_max = thread_qps[0];
+    for (int t = 1; t < threads; t++) {
+        if (thread_qps[t] < *qps_min) *qps_min = thread_qps[t];
+        if (thread_qps[t] > *qps_max) *qps_max = thread_qps[t];
+    }
+    if (threads > 1) *eff = ref_qps > 0.0 ? qps / ((double)threads * ref_qps) : 0.0;
+}
+
+static void print_threads(const double *thread_qps, int threads, double ref_qps,
+                          double eff, long olc_restarts, int64_t nqueries) {
+    printf("Threads:          %d (pinned)\n", threads);
+    for (int t = 0; t < threads; t++)
+        printf("  thread %-3d Q/s: %.2f\n", t, thread_qps[t]);
+    if (threads > 1)
+        printf("Scaling eff:      %.3f (solo %.2f Q/s)\n", eff, ref_qps);
+    printf("OLC restarts:     %ld (%.6f per op)\n", olc_restarts,
+           nqueries ? (double)olc_restarts / (double)nqueries : 0.0);
+}
+
+// --ycsb: YCSB-style core workloads. Every operation (its type, key and
+// scan length) is drawn before the timed loop, inserts included, so the
+// loop only contains index calls and clock reads.
+typedef enum {
+    Y_READ = 0,
+    Y_UPDATE,
+    Y_INSERT,
+    Y_SCAN,
+    Y_RMW,      // read-modify-write: a read, then an update of the same key
+    Y_OPS
+} YcsbOp;
+
+static const char *const ycsb_op_name[Y_OPS] = {
+    "read", "update", "insert", "scan", "rmw"
+};
+
+static const LatKind ycsb_lat_kind[Y_OPS] = {
+    LAT_COLD, LAT_UPDATE, LAT_INSERT, LAT_SCAN, LAT_RMW
+};
+
+// Request distribution over key ranks 0..count-1, where count grows with
+// every insert. zipf favours the lowest ranks (the initial nkeys, with
+// --theta), latest the most recently inserted, and hotspot sends hot_ops
+// of the requests uniformly to the first hot_set of the ranks.
+typedef enum {
+    YD_UNIFORM = 0,
+    YD_ZIPF,
+    YD_LATEST,
+    YD_HOTSPOT
+} YcsbDist;
+
+static const char *const ycsb_dist_name[] = { "uniform", "zipf", "latest", "hotspot" };
+
+typedef struct {
+    const char *name;         // "A".."F", or "custom"
+    double      prop[Y_OPS];  // relative operation weights
+    YcsbDist    dist;
+    int64_t     scan_max;     // scan lengths are uniform in [1, scan_max]
+    double      hot_set, hot_ops;
+} YcsbSpec;
+
+// The six YCSB core workloads. Returns false for an unknown name.
+static bool ycsb_preset(const char *w, YcsbSpec *y) {
+    static const struct { const char *name; double prop[Y_OPS]; YcsbDist dist; } presets[] = {
+        { "A", { 0.50, 0.50, 0,    0,    0    }, YD_ZIPF   },   // update heavy
+        { "B", { 0.95, 0.05, 0,    0,    0    }, YD_ZIPF   },   // read mostly
+        { "C", { 1.00, 0,    0,    0,    0    }, YD_ZIPF   },   // read only
+        { "D", { 0.95, 0,    0.05, 0,    0    }, YD_LATEST },   // read latest
+        { "E", { 0,    0,    0.05, 0.95, 0    }, YD_ZIPF   },   // short ranges
+        { "F", { 0.50, 0,    0,    0,    0.50 }, YD_ZIPF   },   // read-modify-write
+    };
+    for (size_t i = 0; i < sizeof(presets) / sizeof(presets[0]); i++) {
+        if (toupper((unsigned char)w[0]) != presets[i].name[0] || w[1]) continue;
+        y->name = presets[i].name;
+        memcpy(y->prop, presets[i].prop, sizeof(y->prop));
+        y->dist = presets[i].dist;
+        return true;
+    }
+    return false;
+}
+
+typedef struct {
+    uint8_t *op;
+    BTKey   *key;
+    int64_t *rank;      // key's rank, indexes the expected payloads
+    int32_t *len;       // Y_SCAN: number of keys to read
+    int64_t  n;
+    int64_t  inserts;   // keys nkeys..nkeys+inserts-1 (by rank) get inserted
+    int64_t  nranks;    // nkeys + inserts
+} YcsbStream;
+
+static int64_t ycsb_rank(const YcsbSpec *y, ZipfGen *zg, int64_t count) {
+    switch (y->dist) {
+    case YD_ZIPF:
+        return zipf_sample(zg);
+    case YD_LATEST:
+        return count - 1 - zipf_sample(zg);
+    case YD_HOTSPOT: {
+        int64_t hot = (int64_t)(y->hot_set * (double)count);
+        if (hot < 1) hot = 1;
+        if (hot > count) hot = count;
+        if (hot == count || rng_double() < y->hot_ops) return rand_uniform(hot);
+        return hot + rand_uniform(count - hot);
+    }
+    default:
+        return rand_uniform(count);
+    }
+}
+
+static YcsbStream* ycsb_make(const YcsbSpec *y, int64_t nops, int64_t nkeys, double theta,
+                             bool sparse) {
+    YcsbStream *ys = (YcsbStream*)calloc(1, sizeof(YcsbStream));
+    ys->op = (uint8_t*)malloc((size_t)nops);
+    ys->key = (BTKey*)malloc(sizeof(BTKey) * (size_t)nops);
+    ys->rank = (int64_t*)malloc(sizeof(int64_t) * (size_t)nops);
+    ys->len = (int32_t*)malloc(sizeof(int32_t) * (size_t)nops);
+    ZipfGen *zg = y->dist == YD_ZIPF || y->dist == YD_LATEST ? zipf_create(nkeys, theta) : NULL;
+    double total = 0.0;
+    int last = 0;   // last type with a nonzero weight absorbs rounding
+    for (int o = 0; o < Y_OPS; o++) {
+        total += y->prop[o];
+        if (y->prop[o] > 0.0) last = o;
+    }
+    int64_t count = nkeys;
+    for (int64_t i = 0; i < nops; i++) {
+        double u = rng_double() * total;
+        int o = 0;
+        while (o < last && u >= y->prop[o]) u -= y->prop[o++];
+        ys->op[i] = (uint8_t)o;
+        ys->len[i] = o == Y_SCAN ? (int32_t)(1 + rand_uniform(y->scan_max)) : 0;
+        ys->rank[i] = o == Y_INSERT ? count++ : ycsb_rank(y, zg, count);
+        ys->key[i] = key_of(ys->rank[i], sparse);
+    }
+    if (zg) zipf_free(zg);
+    ys->n = nops;
+    ys->inserts = count - nkeys;
+    ys->nranks = count;
+    return ys;
+}
+
+static void ycsb_free(YcsbStream *ys) {
+    if (!ys) return;
+    free(ys->op);
+    free(ys->key);
+    free(ys->rank);
+    free(ys->len);
+    free(ys);
+}
+
+// Per operation type: count, time inside the index calls and node visits.
+// Reads and scans count the nodes the search touched; writes count the
+// levels a top-down insert descends (tree height, plus the hot-copy probe
+// for HCIndex), so write figures are an estimate. stale counts reads (and
+// RMW reads) that returned something other than the last payload written.
+typedef struct {
+    long     ops;
+    uint64_t ns;
+    long     nodes;
+    long     stale;
+} YcsbTally;
+
+static void ycsb_scan_cb(BTKey k, BTPayload v, void *arg) {
+    (void)k;
+    *(uintptr_t*)arg += (uintptr_t)v;
+}
+
+static long hc_all_node_visits(HCShardedIndex *hc) {
+    long n = 0;
+    for (int i = 0; i < hc->nshards; i++) n += hc_node_visits(hc->shard[i]);
+    return n;
+}
+
+// Levels descended by hc_insert: the cold insert plus the hot-copy probe.
+static long hc_write_levels(HCIndex *sh) {
+    return bt_height(sh->cold) + (sh->hot ? bt_height(sh->hot) : 1);
+}
+
+// Replay the stream on exactly one of bt / hc. Updates store a payload
+// derived from the operation index and RMW stores the read payload + 1.
+// Every read is checked against the last payload written to its key, so a
+// stale hot copy shows up in the stale tally. Returns the time spent inside
+// the index calls: node counting and the read check run between them and
+// stay out of it. *misses counts reads (and RMW reads) that found nothing
+// and, for bt, *search_nodes the nodes those lookups visited.
+static double ycsb_run(const YcsbStream *ys, BTree *bt, HCShardedIndex *hc,
+                       YcsbTally *t, long *misses, long *search_nodes, LatSet *lat) {
+    uintptr_t sink = 0;
+    uint64_t total_ns = 0;
+    // Last payload written, by rank; NULL means the bulk-loaded one.
+    BTPayload *want = (BTPayload*)calloc((size_t)ys->nranks, sizeof(BTPayload));
+    for (int64_t i = 0; i < ys->n; i++) {
+        YcsbOp op = (YcsbOp)ys->op[i];
+        BTKey k = ys->key[i];
+        HCIndex *sh = hc ? hc->shard[hc_shard_of(hc, k)] : NULL;
+        long before = !hc ? 0 : op == Y_SCAN ? hc_all_node_visits(hc) : hc_node_visits(sh);
+        BTStats s = {0};
+        BTPayload v = NULL, got = NULL;
+        bool miss = false;
+        LatKind kind = ycsb_lat_kind[op];
+        uint64_t ta = now_ns();
+        switch (op) {
+        case Y_READ:
+        case Y_RMW:
+            v = got = bt ? bt_search(bt, k, &s) : hc_sharded_search(hc, k);
+            miss = v == NULL;
+            if (op == Y_READ) {
+                kind = bt ? (miss ? LAT_MISS : LAT_COLD) : lat_kind_of(hc_last_outcome());
+                break;
+            }
+            v = miss ? make_payload(k) : (BTPayload)((intptr_t)v + 1);
+            if (bt) bt_insert(bt, k, v);
+            else hc_sharded_insert(hc, k, v);
+            break;
+        case Y_UPDATE:
+        case Y_INSERT:
+            v = op == Y_UPDATE ? (BTPayload)(intptr_t)(i + 1) : make_payload(k);
+            if (bt) bt_insert(bt, k, v);
+            else hc_sharded_insert(hc, k, v);
+            break;
+        case Y_SCAN:
+            if (bt) {
+                BTCursor c;
+                int32_t n = 0;
+                for (bt_cursor_seek(&c, bt, k, &s); n < ys->len[i] && bt_cursor_valid(&c);
+                     bt_cursor_next(&c), n++)
+                    sink += (uintptr_t)bt_cursor_value(&c);
+            } else {
+                hc_sharded_scan(hc, k, (size_t)ys->len[i], ycsb_scan_cb, &sink);
+            }
+            break;
+        default:
+            break;
+        }
+        uint64_t ns = now_ns() - ta;
+        if (lat) lat_record(lat, kind, ns);
+        total_ns += ns;
+
+        BTPayload *w = &want[ys->rank[i]];
+        if (op == Y_READ || op == Y_RMW)
+            t[op].stale += got != (*w ? *w : make_payload(k));
+        if (op == Y_UPDATE || op == Y_INSERT || op == Y_RMW) *w = v;
+
+        long nodes = s.node_visits;
+        if (op == Y_READ || op == Y_RMW) *search_nodes += s.node_visits;
+        if (hc) nodes = (op == Y_SCAN ? hc_all_node_visits(hc) : hc_node_visits(sh)) - before;
+        if (op == Y_UPDATE || op == Y_INSERT || op == Y_RMW)
+            nodes += bt ? bt_height(bt) : hc_write_levels(sh);
+        *misses += miss;
+        t[op].ops++;
+        t[op].ns += ns;
+        t[op].nodes += nodes;
+    }
+    free(want);
+    (void)sink;
+    return (double)total_ns * 1e-9;
+}
+
+static void print_ycsb(const YcsbSpec *y, const YcsbTally *t) {
+    printf("YCSB workload:    %s (%s", y->name, ycsb_dist_name[y->dist]);
+    if (y->dist == YD_HOTSPOT) printf(" %.2f/%.2f", y->hot_set, y->hot_ops);
+    printf(")\n");
+    printf("  %-10s %10s %14s %9s %9s\n", "op", "ops", "Q/s", "ns/op", "nodes/op");
+    for (int o = 0; o < Y_OPS; o++) {
+        if (!t[o].ops) continue;
+        printf("  %-10s %10ld %14.2f %9.1f %9.3f\n", ycsb_op_name[o], t[o].ops,
+               t[o].ns ? (double)t[o].ops * 1e9 / (double)t[o].ns : 0.0,
+               (double)t[o].ns / (double)t[o].ops, (double)t[o].nodes / (double)t[o].ops);
+    }
+    printf("  stale reads: %ld\n", t[Y_READ].stale + t[Y_RMW].stale);
+}
+
+// CSV: ops, Q/s (from time inside the calls) and nodes/op per operation
+// type, in ycsb_op_name order; zeros without --ycsb.
+static void print_ycsb_csv(const YcsbTally *t) {
+    for (int o = 0; o < Y_OPS; o++) {
+        printf(",%ld,%.2f,%.3f", t[o].ops,
+               t[o].ns ? (double)t[o].ops * 1e9 / (double)t[o].ns : 0.0,
+               t[o].ops ? (double)t[o].nodes / (double)t[o].ops : 0.0);
+    }
+}
+
+// "--read" etc. to its YcsbOp, or -1.
+static int ycsb_op_flag(const char *arg) {
+    if (strncmp(arg, "--", 2)) return -1;
+    for (int o = 0; o < Y_OPS; o++) {
+        if (!strcmp(arg + 2, ycsb_op_name[o])) return o;
+    }
+    return -1;
+}
+
 static void usage(const char *prog) {
     fprintf(stderr,
         "Usage: %s [options]\n"
@@ -85,7 +811,62 @@ static void usage(const char *prog) {
         "  --decay A         decay alpha (default 0.9)\n"
         "  --hot_frac F      max hot fraction (default 0.05)\n"
         "  --seed SEED       RNG seed (default 42)\n"
-        "  --mode MODE       'hctree' (default) or 'baseline'\n"
+        "  --build HOW       'bulk' (default, bottom-up bulk load) or 'insert'\n"
+        "  --fill F          node fill factor for bulk build (default 1.0)\n"
+        "  --evict POLICY    hot-tier eviction when full: none (default), clock,\n"
+        "                    lru, score\n"
+        "  --shift_every Q   move the hotspot by nkeys/3 every Q queries (default 0 = never)\n"
+        "  --epoch_queries N age hit scores by decay alpha once per N queries\n"
+        "                    instead of once per access\n"
+        "  --epoch_sec S     same, with wall-clock epochs of S seconds\n"
+        "  --heat BACKEND    hit-score storage: dense (default), sketch\n"
+        "                    (Count-Min Sketch, TinyLFU-style aging) or table\n"
+        "                    (sparse per-key table)\n"
+        "  --sketch_counters N  sketch size in counters (default: 8 per hot slot)\n"
+        "  --sparse_keys     scatter keys over the full int64 range (unbounded\n"
+        "                    key domain; implies --heat table unless sketch)\n"
+        "  --batch N         issue lookups in batches of N through the group-\n"
+        "                    prefetched batch API (default 1 = one at a time)\n"
+        "  --miss_frac F     fraction of lookups for keys that are not in the\n"
+        "                    index (default 0)\n"
+        "  --filter_bits B   Bloom filter with B bits per key in front of the\n"
+        "                    cold tier (default 0 = none; 10 gives ~1%% false hits)\n"
+        "  --delete_frac F   fraction of operations that delete a uniformly\n"
+        "                    drawn key instead of looking one up (default 0)\n"
+        "  --mode MODE       'hctree' (default), 'baseline', or 'kernels'\n"
+        "                    (kernels: compare in-node search kernels across degrees)\n"
+        "  --search_kernel K auto (default), scalar, binary, sse4.2, avx2, neon\n"
+        "  --hot_tree T      hot-tier engine: btree (default), bplus, hash\n"
+        "                    (Swiss-table style map) or eytzinger (immutable\n"
+        "                    snapshot + delta buffer); hash and eytzinger\n"
+        "                    serve point lookups only\n"
+        "  --hot_rebuild N   eytzinger: promotions per snapshot rebuild (default 64)\n"
+        "  --concurrent      build a thread-safe index (optimistic lock coupling;\n"
+        "                    tree hot tier, dense heat, no eviction or filter)\n"
+        "  --shards N        split the key range over N independent HCIndex\n"
+        "                    shards (default 1, at most 256)\n"
+        "  --pregen          draw the whole query stream before the timed loop\n"
+        "                    (always on with --threads)\n"
+        "  --latency         time every operation (clock_gettime) into log-linear\n"
+        "                    histograms by outcome; adds p50/p99/p99.9 columns\n"
+        "  --threads N       replay pre-generated per-thread key streams on N\n"
+        "                    pinned threads between start/stop barriers; N > 1\n"
+        "                    implies --concurrent (hctree) or a concurrent tree\n"
+        "  --async_promote   apply promotions on a background thread fed by a\n"
+        "                    lock-free queue (--promote_queue N slots, default 4096)\n"
+        "  --cold_tree T     cold-tier engine (and the baseline tree): btree\n"
+        "                    (default) or bplus (B+tree with linked leaves)\n"
+        "  --ycsb W          replace the lookup loop by YCSB core workload A-F over\n"
+        "                    --nqueries operations: A 50/50 read/update, B 95/5\n"
+        "                    read/update, C read only, D 95/5 read/insert (latest),\n"
+        "                    E 95/5 scan/insert, F 50/50 read/read-modify-write\n"
+        "  --read P, --update P, --insert P, --scan P, --rmw P\n"
+        "                    override one operation weight (alone: a custom mix)\n"
+        "  --dist D          YCSB key distribution: uniform, zipf (--theta),\n"
+        "                    latest or hotspot (default: the workload's own)\n"
+        "  --scan_max N      longest scan, lengths uniform in [1, N] (default 100)\n"
+        "  --hotspot_frac F  hotspot: fraction of keys that is hot (default 0.2)\n"
+        "  --hotspot_ops F   hotspot: fraction of requests sent to it (default 0.8)\n"
         "  --disable_hot     alias for --mode baseline\n"
         "  --csv             output one line of CSV instead of human-readable text\n"
         "  --csv_header      print CSV header and exit\n",
@@ -94,9 +875,79 @@ static void usage(const char *prog) {
 
 typedef enum {
     MODE_HCTREE = 0,
-    MODE_BASELINE = 1
+    MODE_BASELINE = 1,
+    MODE_KERNELS = 2
 } RunMode;
 
+static const BTSearchKernel all_kernels[] = {
+    BT_SEARCH_SCALAR, BT_SEARCH_BINARY, BT_SEARCH_SSE42,
+    BT_SEARCH_AVX2, BT_SEARCH_NEON
+};
+
+static bool parse_kernel(const char *name, BTSearchKernel *out) {
+    if (!strcmp(name, "auto")) { *out = BT_SEARCH_AUTO; return true; }
+    for (size_t i = 0; i < sizeof(all_kernels) / sizeof(all_kernels[0]); i++) {
+        if (!strcmp(name, bt_search_kernel_name(all_kernels[i]))) {
+            *out = all_kernels[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+// --mode kernels: time bt_search with every available in-node search
+// kernel over a range of B-tree degrees. Query keys are generated up front
+// so the timed loop only measures lookups.
+static void run_kernel_bench(int64_t nkeys, int64_t nqueries,
+                             const char *workload, double theta, bool csv) {
+    static const int degrees[] = { 4, 8, 16, 32, 64, 128 };
+
+    int64_t *qkeys = (int64_t*)malloc(sizeof(int64_t) * (size_t)nqueries);
+    ZipfGen *zg = !strcmp(workload, "zipf") ? zipf_create(nkeys, theta) : NULL;
+    for (int64_t q = 0; q < nqueries; q++)
+        qkeys[q] = zg ? zipf_sample(zg) : rand_uniform(nkeys);
+    if (zg) zipf_free(zg);
+
+    if (csv)
+        printf("kernel,degree,workload,theta,nkeys,nqueries,elapsed_sec,qps,"
+               "avg_nodes_per_q,ns_per_query\n");
+    else
+        printf("%-8s %6s %14s %10s %10s\n",
+               "kernel", "degree", "Q/s", "nodes/q", "ns/q");
+
+    for (size_t d = 0; d < sizeof(degrees) / sizeof(degrees[0]); d++) {
+        BTree *bt = bt_create(degrees[d]);
+        for (int64_t k = 0; k < nkeys; k++)
+            bt_insert(bt, k, make_payload(k));
+
+        for (size_t kk = 0; kk < sizeof(all_kernels) / sizeof(all_kernels[0]); kk++) {
+            if (!bt_set_search_kernel(all_kernels[kk])) continue;
+
+            BTStats s = {0};
+            long hits = 0;
+            double t0 = now_seconds();
+            for (int64_t q = 0; q < nqueries; q++)
+                hits += bt_search(bt, qkeys[q], &s) != NULL;
+            double elapsed = now_seconds() - t0;
+            (void)hits;
+
+            double qps = elapsed > 0.0 ? (double)nqueries / elapsed : 0.0;
+            double nodes_q = nqueries ? (double)s.node_visits / (double)nqueries : 0.0;
+            double ns_q = nqueries ? elapsed * 1e9 / (double)nqueries : 0.0;
+            const char *name = bt_search_kernel_name(all_kernels[kk]);
+            if (csv)
+                printf("%s,%d,%s,%.5f,%" PRId64 ",%" PRId64 ",%.6f,%.2f,%.6f,%.3f\n",
+                       name, degrees[d], workload, theta, nkeys, nqueries,
+                       elapsed, qps, nodes_q, ns_q);
+            else
+                printf("%-8s %6d %14.2f %10.3f %10.2f\n",
+                       name, degrees[d], qps, nodes_q, ns_q);
+        }
+        bt_free(bt);
+    }
+    free(qkeys);
+}
+
 int main(int argc, char **argv) {
     int64_t nkeys = 100000;
     int64_t nqueries = 500000;
@@ -109,6 +960,37 @@ int main(int argc, char **argv) {
     RunMode mode = MODE_HCTREE;
     bool csv = false;
     bool csv_header = false;
+    BTSearchKernel kernel = BT_SEARCH_AUTO;
+    bool bulk_build = true;
+    double fill = 1.0;
+    double delete_frac = 0.0;
+    HCEvictPolicy evict = HC_EVICT_NONE;
+    int64_t shift_every = 0;
+    HCEpochMode epoch_mode = HC_EPOCH_NONE;
+    double epoch_length = 0.0;
+    HCHeatBackend heat = HC_HEAT_DENSE;
+    size_t sketch_counters = 0;
+    bool sparse = false;
+    BTVariant hot_variant = BT_VARIANT_BTREE;
+    BTVariant cold_variant = BT_VARIANT_BTREE;
+    HCHotTier hot_tier = HC_HOT_TREE;
+    size_t hot_rebuild = 0;
+    int64_t batch = 1;
+    double miss_frac = 0.0;
+    double filter_bits = 0.0;
+    bool async_promote = false;
+    bool concurrent = false;
+    bool latency = false;
+    bool pregen = false;
+    size_t promote_queue = 0;
+    int shards = 1;
+    int threads = 0;   // 0 = single-threaded loop drawing keys as it goes
+    long olc_restarts = 0;
+    long promote_dropped = 0, hot_bypassed = 0;
+    bool use_ycsb = false;
+    YcsbSpec ycsb = { "custom", { 0 }, YD_ZIPF, 100, 0.2, 0.8 };
+    double ycsb_prop[Y_OPS] = { -1, -1, -1, -1, -1 };   // < 0 = preset's own
+    int ycsb_dist = -1;
 
     for (int i = 1; i < argc; i++) {
         if (!strcmp(argv[i], "--nkeys") && i+1 < argc) {
@@ -127,15 +1009,142 @@ int main(int argc, char **argv) {
             hot_frac = atof(argv[++i]);
         } else if (!strcmp(argv[i], "--seed") && i+1 < argc) {
             seed = (unsigned int)atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--build") && i+1 < argc) {
+            const char *b = argv[++i];
+            if (!strcmp(b, "bulk")) bulk_build = true;
+            else if (!strcmp(b, "insert")) bulk_build = false;
+            else {
+                fprintf(stderr, "Unknown build method '%s'\n", b);
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (!strcmp(argv[i], "--fill") && i+1 < argc) {
+            fill = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--evict") && i+1 < argc) {
+            const char *e = argv[++i];
+            if (!strcmp(e, "none")) evict = HC_EVICT_NONE;
+            else if (!strcmp(e, "clock")) evict = HC_EVICT_CLOCK;
+            else if (!strcmp(e, "lru")) evict = HC_EVICT_LRU;
+            else if (!strcmp(e, "score")) evict = HC_EVICT_SCORE;
+            else {
+                fprintf(stderr, "Unknown eviction policy '%s'\n", e);
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (!strcmp(argv[i], "--shift_every") && i+1 < argc) {
+            shift_every = atoll(argv[++i]);
+        } else if (!strcmp(argv[i], "--epoch_queries") && i+1 < argc) {
+            epoch_mode = HC_EPOCH_QUERIES;
+            epoch_length = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--epoch_sec") && i+1 < argc) {
+            epoch_mode = HC_EPOCH_SECONDS;
+            epoch_length = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--heat") && i+1 < argc) {
+            const char *h = argv[++i];
+            if (!strcmp(h, "dense")) heat = HC_HEAT_DENSE;
+            else if (!strcmp(h, "sketch")) heat = HC_HEAT_SKETCH;
+            else if (!strcmp(h, "table")) heat = HC_HEAT_TABLE;
+            else {
+                fprintf(stderr, "Unknown heat backend '%s'\n", h);
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (!strcmp(argv[i], "--sketch_counters") && i+1 < argc) {
+            sketch_counters = (size_t)atoll(argv[++i]);
+        } else if (!strcmp(argv[i], "--sparse_keys")) {
+            sparse = true;
+        } else if (!strcmp(argv[i], "--batch") && i+1 < argc) {
+            batch = atoll(argv[++i]);
+            if (batch < 1) batch = 1;
+        } else if (!strcmp(argv[i], "--miss_frac") && i+1 < argc) {
+            miss_frac = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--filter_bits") && i+1 < argc) {
+            filter_bits = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--delete_frac") && i+1 < argc) {
+            delete_frac = atof(argv[++i]);
         } else if (!strcmp(argv[i], "--mode") && i+1 < argc) {
             const char *m = argv[++i];
             if (!strcmp(m, "hctree")) mode = MODE_HCTREE;
             else if (!strcmp(m, "baseline")) mode = MODE_BASELINE;
+            else if (!strcmp(m, "kernels")) mode = MODE_KERNELS;
             else {
                 fprintf(stderr, "Unknown mode '%s'\n", m);
                 usage(argv[0]);
                 return 1;
             }
+        } else if (!strcmp(argv[i], "--search_kernel") && i+1 < argc) {
+            const char *kname = argv[++i];
+            if (!parse_kernel(kname, &kernel)) {
+                fprintf(stderr, "Unknown search kernel '%s'\n", kname);
+                usage(argv[0]);
+                return 1;
+            }
+        } else if ((!strcmp(argv[i], "--hot_tree") || !strcmp(argv[i], "--cold_tree"))
+                   && i+1 < argc) {
+            bool hot = !strcmp(argv[i], "--hot_tree");
+            BTVariant *dst = hot ? &hot_variant : &cold_variant;
+            const char *tname = argv[++i];
+            if (hot) hot_tier = HC_HOT_TREE;
+            if (hot && !strcmp(tname, "hash")) hot_tier = HC_HOT_HASH;
+            else if (hot && !strcmp(tname, "eytzinger")) hot_tier = HC_HOT_EYTZINGER;
+            else if (!strcmp(tname, "btree")) *dst = BT_VARIANT_BTREE;
+            else if (!strcmp(tname, "bplus")) *dst = BT_VARIANT_BPLUS;
+            else {
+                fprintf(stderr, "Unknown tree engine '%s'\n", tname);
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (!strcmp(argv[i], "--hot_rebuild") && i+1 < argc) {
+            hot_rebuild = (size_t)atoll(argv[++i]);
+        } else if (!strcmp(argv[i], "--pregen")) {
+            pregen = true;
+        } else if (!strcmp(argv[i], "--latency")) {
+            latency = true;
+        } else if (!strcmp(argv[i], "--concurrent")) {
+            concurrent = true;
+        } else if (!strcmp(argv[i], "--threads") && i+1 < argc) {
+            threads = atoi(argv[++i]);
+            if (threads < 1) {
+                fprintf(stderr, "--threads needs N >= 1\n");
+                return 1;
+            }
+        } else if (!strcmp(argv[i], "--shards") && i+1 < argc) {
+            shards = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--async_promote")) {
+            async_promote = true;
+        } else if (!strcmp(argv[i], "--promote_queue") && i+1 < argc) {
+            promote_queue = (size_t)atoll(argv[++i]);
+        } else if (!strcmp(argv[i], "--ycsb") && i+1 < argc) {
+            const char *w = argv[++i];
+            if (!ycsb_preset(w, &ycsb)) {
+                fprintf(stderr, "Unknown YCSB workload '%s'\n", w);
+                usage(argv[0]);
+                return 1;
+            }
+            use_ycsb = true;
+        } else if (ycsb_op_flag(argv[i]) >= 0 && i+1 < argc) {
+            int o = ycsb_op_flag(argv[i]);
+            ycsb_prop[o] = atof(argv[++i]);
+            if (ycsb_prop[o] < 0.0) ycsb_prop[o] = 0.0;
+            use_ycsb = true;
+        } else if (!strcmp(argv[i], "--dist") && i+1 < argc) {
+            const char *d = argv[++i];
+            ycsb_dist = -1;
+            for (int j = 0; j < (int)(sizeof(ycsb_dist_name) / sizeof(ycsb_dist_name[0])); j++) {
+                if (!strcmp(d, ycsb_dist_name[j])) ycsb_dist = j;
+            }
+            if (ycsb_dist < 0) {
+                fprintf(stderr, "Unknown key distribution '%s'\n", d);
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (!strcmp(argv[i], "--scan_max") && i+1 < argc) {
+            ycsb.scan_max = atoll(argv[++i]);
+            if (ycsb.scan_max < 1) ycsb.scan_max = 1;
+        } else if (!strcmp(argv[i], "--hotspot_frac") && i+1 < argc) {
+            ycsb.hot_set = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--hotspot_ops") && i+1 < argc) {
+            ycsb.hot_ops = atof(argv[++i]);
         } else if (!strcmp(argv[i], "--disable_hot")) {
             mode = MODE_BASELINE;
         } else if (!strcmp(argv[i], "--csv")) {
@@ -152,36 +1161,121 @@ int main(int argc, char **argv) {
         // Print header and exit; no experiment.
         printf("mode,workload,theta,nkeys,nqueries,hot_threshold,decay_alpha,hot_fraction,seed,"
                "elapsed_sec,qps,hot_hits,cold_hits,not_found,hot_keys,cold_keys,"
-               "avg_hot_nodes_per_q,avg_cold_nodes_per_q\n");
+               "avg_hot_nodes_per_q,avg_cold_nodes_per_q,node_layout,ns_per_node_visit,"
+               "build_sec,deletes,evict_policy,promotions,demotions,"
+               "hot_hit_ratio_after_shift,heat_backend,heat_bytes,hot_tree,cold_tree,batch,"
+               "not_found_filtered,filter_bytes,async_promote,promote_dropped,hot_bypassed,"
+               "shards,threads,qps_thread_min,qps_thread_max,olc_restarts,scaling_eff,"
+               "lat_p50_ns,lat_p99_ns,lat_p999_ns,hot_p50_ns,hot_p99_ns,hot_p999_ns,"
+               "cold_p50_ns,cold_p99_ns,cold_p999_ns,miss_p50_ns,miss_p99_ns,miss_p999_ns,"
+               "promote_p50_ns,promote_p99_ns,promote_p999_ns,pregen,ycsb,ycsb_dist,"
+               "read_ops,read_qps,read_nodes,update_ops,update_qps,update_nodes,"
+               "insert_ops,insert_qps,insert_nodes,scan_ops,scan_qps,scan_nodes,"
+               "rmw_ops,rmw_qps,rmw_nodes\n");
         return 0;
     }
 
-    srand(seed);
+    if (use_ycsb) {
+        double total = 0.0;
+        for (int o = 0; o < Y_OPS; o++) {
+            if (ycsb_prop[o] >= 0.0) ycsb.prop[o] = ycsb_prop[o];
+            total += ycsb.prop[o];
+        }
+        if (ycsb_dist >= 0) ycsb.dist = (YcsbDist)ycsb_dist;
+        if (total <= 0.0) {
+            fprintf(stderr, "--ycsb needs at least one operation weight > 0\n");
+            return 1;
+        }
+        if (threads > 0) {
+            fprintf(stderr, "--ycsb runs single-threaded; drop --threads\n");
+            return 1;
+        }
+    }
+
+    rng_seed(seed);
+
+    if (mode == MODE_KERNELS) {
+        run_kernel_bench(nkeys, nqueries, workload, theta, csv);
+        return 0;
+    }
+
+    if (!bt_set_search_kernel(kernel)) {
+        fprintf(stderr, "Search kernel '%s' not supported on this CPU\n",
+                bt_search_kernel_name(kernel));
+        return 1;
+    }
 
     int btree_degree = 32; // B-tree min degree (t)
 
-    double t0, t1, elapsed, qps;
+    double t0, t1, elapsed, qps, build_sec;
 
     long hot_hits = 0;
     long cold_hits = 0;
     long not_found = 0;
+    long deletes = 0;
+    long promotions = 0;
+    long demotions = 0;
+    double shift_hot_ratio = 0.0;  // hot hits / lookups since the last shift
+    int64_t shift = 0;
+    size_t heat_bytes = 0;
+    long not_found_filtered = 0;
+    size_t filter_bytes = 0;
     size_t hot_keys = 0;
     size_t cold_keys = 0;
     double avg_hot_nodes_q = 0.0;
     double avg_cold_nodes_q = 0.0;
+    double ns_per_node = 0.0;   // elapsed time / total node visits
+    double *thread_qps = (double*)calloc(threads > 0 ? (size_t)threads : 1, sizeof(double));
+    double ref_qps = 0.0;   // --threads N > 1: one thread alone
+    LatSet *lat = latency ? lat_create() : NULL;
+    double qps_thread_min = 0.0, qps_thread_max = 0.0, scaling_eff = 1.0;
+    YcsbTally ytally[Y_OPS] = { { 0 } };
+
+    if (sparse && heat == HC_HEAT_DENSE) heat = HC_HEAT_TABLE;
+    const char *hot_tree_name = hot_tier != HC_HOT_TREE
+                              ? hc_hot_tier_name(hot_tier) : bt_variant_name(hot_variant);
+
+    // Build input, sorted for the bulk loader.
+    BTKey     *build_keys = (BTKey*)malloc(sizeof(BTKey) * (size_t)nkeys);
+    BTPayload *build_vals = (BTPayload*)malloc(sizeof(BTPayload) * (size_t)nkeys);
+    for (int64_t k = 0; k < nkeys; k++)
+        build_keys[k] = key_of(k, sparse);
+    if (sparse)
+        qsort(build_keys, (size_t)nkeys, sizeof(BTKey), cmp_int64);
+    for (int64_t k = 0; k < nkeys; k++)
+        build_vals[k] = make_payload(build_keys[k]);
+
+    // Lookup keys waiting for the next batch call (--batch > 1).
+    BTKey     *batch_keys = (BTKey*)malloc(sizeof(BTKey) * (size_t)batch);
+    BTPayload *batch_out  = (BTPayload*)malloc(sizeof(BTPayload) * (size_t)batch);
+    size_t     nbatch = 0;
 
     ZipfGen *zg = NULL;
     if (!strcmp(workload, "zipf")) {
         zg = zipf_create(nkeys, theta);
     }
+    YcsbStream *ys = use_ycsb ? ycsb_make(&ycsb, nqueries, nkeys, theta, sparse) : NULL;
 
     if (mode == MODE_HCTREE) {
         // --- Hot/Cold index mode ---
-        HCParams params;
+        HCParams params = {0};
         params.decay_alpha   = decay_alpha;
         params.hot_threshold = hot_thresh;
         params.max_hot_fraction = hot_frac;
         params.inclusive     = 1;
+        params.evict_policy  = evict;
+        params.epoch_mode    = epoch_mode;
+        params.epoch_length  = epoch_length;
+        params.heat_backend  = heat;
+        params.sketch_counters = sketch_counters;
+        params.hot_tier      = hot_tier;
+        params.hot_rebuild_every = hot_rebuild;
+        params.hot_variant   = hot_variant;
+        params.cold_variant  = cold_variant;
+        params.cold_filter_bits = filter_bits;
+        params.async_promote = async_promote;
+        params.promote_queue = promote_queue;
+        params.concurrent = concurrent || threads > 1;
 
         if (!csv) {
             printf("Mode:       HCIndex (hot/cold)\n");
@@ -193,53 +1287,159 @@ int main(int argc, char **argv) {
             printf("HotThresh:  %.3f\n", hot_thresh);
             printf("Decay alpha:%.3f\n", decay_alpha);
             printf("Hot frac:   %.3f\n", hot_frac);
+            printf("Eviction:   %s\n", hc_evict_policy_name(evict));
+            if (epoch_mode != HC_EPOCH_NONE)
+                printf("Epoch:      %g %s\n", epoch_length,
+                       epoch_mode == HC_EPOCH_QUERIES ? "queries" : "sec");
+            printf("Heat:       %s\n", hc_heat_backend_name(heat));
+            printf("Trees:      hot %s, cold %s\n", hot_tree_name,
+                   bt_variant_name(cold_variant));
+            printf("Promotion:  %s\n", async_promote ? "async" : "inline");
+            if (params.concurrent)
+                printf("Concurrency: optimistic lock coupling\n");
         }
 
-        HCIndex *idx = hc_create(nkeys - 1, btree_degree, params);
-
-        // Build cold index
-        for (int64_t k = 0; k < nkeys; k++) {
-            hc_insert(idx, k, make_payload(k));
+        // YCSB inserts extend the dense domain past the initial keys.
+        int64_t max_key = sparse ? HC_KEY_UNBOUNDED : nkeys - 1 + (ys ? ys->inserts : 0);
+        OpStream *streams = threads > 0
+            ? make_streams(threads, nqueries, zg, nkeys, sparse, miss_frac, delete_frac, shift_every)
+            : NULL;
+        if (threads > 1) {
+            // Solo reference first, on its own copy of the index.
+            HCShardedIndex *ref = hc_sharded_create(max_key, shards, btree_degree, params);
+            if (!ref) return 1;
+            fill_hc(ref, build_keys, build_vals, nkeys, bulk_build, fill);
+            ref_qps = solo_qps(streams, NULL, ref, batch);
+            hc_sharded_free(ref);
         }
 
+        HCShardedIndex *idx = hc_sharded_create(max_key, shards, btree_degree, params);
+        if (!idx) return 1;
+        shards = idx->nshards;
+        if (!csv)
+            printf("Shards:     %d\n", shards);
+
+        // Build cold index
         t0 = now_seconds();
-        for (int64_t q = 0; q < nqueries; q++) {
-            int64_t k;
-            if (!strcmp(workload, "zipf")) {
-                k = zipf_sample(zg);
-            } else {
-                k = rand_uniform(nkeys);
+        fill_hc(idx, build_keys, build_vals, nkeys, bulk_build, fill);
+        build_sec = now_seconds() - t0;
+
+        long shift_queries = 0, shift_hot_hits = 0;  // counters at last shift
+        OpStream *pre = !streams && !ys && pregen
+            ? make_streams(1, nqueries, zg, nkeys, sparse, miss_frac, delete_frac, shift_every)
+            : NULL;
+        if (ys) {
+            long ymisses = 0, ynodes = 0;   // HCStats has both already
+            elapsed = ycsb_run(ys, NULL, idx, ytally, &ymisses, &ynodes, lat);
+        } else if (streams) {
+            elapsed = run_streams(streams, threads, NULL, idx, batch, thread_qps, NULL, lat);
+        } else {
+            t0 = now_seconds();
+            for (int64_t q = 0; q < nqueries; q++) {
+                int64_t k;
+                bool shift_now = shift_every > 0 && q > 0 && q % shift_every == 0;
+                bool del = pre ? pre->del[q] : delete_frac > 0.0 && rng_double() < delete_frac;
+                // Pending lookups run before the shift snapshot or delete.
+                if (shift_now || del) run_hc_batch(idx, batch_keys, &nbatch, batch_out, lat);
+                if (shift_now) {
+                    shift = (shift + nkeys / 3) % nkeys;
+                    HCStats at = hc_sharded_get_stats(idx);
+                    shift_queries = at.queries;
+                    shift_hot_hits = at.hot_hits;
+                }
+                if (del) {
+                    k = pre ? pre->keys[q] : key_of(rand_uniform(nkeys), sparse);
+                    uint64_t ta = lat ? now_ns() : 0;
+                    (void)hc_sharded_delete(idx, k);
+                    if (lat) lat_record(lat, LAT_DELETE, now_ns() - ta);
+                    continue;
+                }
+                k = pre ? pre->keys[q] : draw_key(zg, nkeys, shift, sparse, miss_frac);
+                if (batch > 1) {
+                    batch_keys[nbatch++] = k;
+                    if (nbatch == (size_t)batch)
+                        run_hc_batch(idx, batch_keys, &nbatch, batch_out, lat);
+                } else {
+                    uint64_t ta = lat ? now_ns() : 0;
+                    (void)hc_sharded_search(idx, k);
+                    if (lat) lat_record(lat, lat_kind_of(hc_last_outcome()), now_ns() - ta);
+                }
             }
-            (void)hc_search(idx, k);
+            run_hc_batch(idx, batch_keys, &nbatch, batch_out, lat);
+            t1 = now_seconds();
+            elapsed = t1 - t0;
         }
-        t1 = now_seconds();
+        if (pre) free_streams(pre, 1);
+        hc_sharded_sync(idx);   // count promotions still in the queue
 
-        HCStats s = hc_get_stats(idx);
-        elapsed = t1 - t0;
+        HCStats s = hc_sharded_get_stats(idx);
         qps = (elapsed > 0.0) ? (double)nqueries / elapsed : 0.0;
 
         hot_hits = s.hot_hits;
         cold_hits = s.cold_hits;
         not_found = s.not_found;
+        deletes = s.deletes;
+        promotions = s.promotions;
+        heat_bytes = s.heat_bytes;
+        not_found_filtered = s.not_found_filtered;
+        filter_bytes = s.filter_bytes;
+        demotions = s.demotions;
+        promote_dropped = s.promote_dropped;
+        hot_bypassed = s.hot_bypassed;
+        olc_restarts = s.olc_restarts;
+        shift_hot_ratio = !streams && s.queries > shift_queries
+                        ? (double)(s.hot_hits - shift_hot_hits) / (double)(s.queries - shift_queries)
+                        : 0.0;
         hot_keys = s.hot_keys;
         cold_keys = s.cold_keys;
         avg_hot_nodes_q  = s.queries ? (double)s.hot_node_visits  / (double)s.queries : 0.0;
         avg_cold_nodes_q = s.queries ? (double)s.cold_node_visits / (double)s.queries : 0.0;
+        long visits = s.hot_node_visits + s.cold_node_visits;
+        ns_per_node = visits ? elapsed * 1e9 / (double)visits : 0.0;
+
+        if (streams) free_streams(streams, threads);
+        thread_summary(thread_qps, threads, qps, ref_qps,
+                       &qps_thread_min, &qps_thread_max, &scaling_eff);
 
         if (!csv) {
             printf("\n=== Results (HCIndex) ===\n");
+            printf("Build (sec):      %.6f (%s)\n", build_sec, bulk_build ? "bulk" : "insert");
             printf("Elapsed (sec):    %.6f\n", elapsed);
             printf("Throughput (Q/s): %.2f\n", qps);
+            if (threads > 0)
+                print_threads(thread_qps, threads, ref_qps, scaling_eff, olc_restarts, nqueries);
+            if (ys)
+                print_ycsb(&ycsb, ytally);
             printf("Hot hits:         %ld\n", hot_hits);
             printf("Cold hits:        %ld\n", cold_hits);
             printf("Not found:        %ld\n", not_found);
+            if (filter_bytes)
+                printf("  filtered:       %ld (filter %zu bytes)\n",
+                       not_found_filtered, filter_bytes);
+            if (deletes)
+                printf("Deletes:          %ld\n", deletes);
+            printf("Promotions:       %ld\n", promotions);
+            printf("Demotions:        %ld\n", demotions);
+            if (s.hot_rebuilds)
+                printf("Hot rebuilds:     %ld\n", s.hot_rebuilds);
+            if (async_promote)
+                printf("Queue drops:      %ld (hot bypassed %ld)\n",
+                       promote_dropped, hot_bypassed);
+            if (shift_every > 0)
+                printf("Hot-hit ratio since last shift: %.4f\n", shift_hot_ratio);
+            printf("Heat state bytes: %zu\n", heat_bytes);
+            if (batch > 1)
+                printf("Batch size:       %" PRId64 "\n", batch);
             printf("Hot keys:         %zu\n", hot_keys);
             printf("Cold keys:        %zu\n", cold_keys);
             printf("Avg hot nodes/q:  %.3f\n", avg_hot_nodes_q);
             printf("Avg cold nodes/q: %.3f\n", avg_cold_nodes_q);
+            printf("Node layout:      %s\n", bt_node_layout());
+            printf("Search kernel:    %s\n", bt_search_kernel_name(bt_get_search_kernel()));
+            printf("ns / node visit:  %.2f\n", ns_per_node);
         }
 
-        hc_free(idx);
+        hc_sharded_free(idx);
     } else {
         // --- Baseline mode: single B-tree only ---
         if (!csv) {
@@ -249,65 +1449,141 @@ int main(int argc, char **argv) {
                 printf("Theta:      %.3f\n", theta);
             printf("nkeys:      %" PRId64 "\n", nkeys);
             printf("nqueries:   %" PRId64 "\n", nqueries);
+            printf("Tree:       %s\n", bt_variant_name(cold_variant));
         }
 
-        BTree *bt = bt_create(btree_degree);
+        OpStream *streams = threads > 0
+            ? make_streams(threads, nqueries, zg, nkeys, sparse, miss_frac, delete_frac, shift_every)
+            : NULL;
+        if (threads > 1) {
+            // Solo reference first, on its own copy of the index.
+            BTree *ref = bt_create_variant(btree_degree, cold_variant);
+            fill_bt(ref, build_keys, build_vals, nkeys, bulk_build, fill);
+            bt_make_concurrent(ref);
+            ref_qps = solo_qps(streams, ref, NULL, batch);
+            bt_free(ref);
+        }
+
+        BTree *bt = bt_create_variant(btree_degree, cold_variant);
 
         // Build baseline index
-        for (int64_t k = 0; k < nkeys; k++) {
-            bt_insert(bt, k, make_payload(k));
-        }
+        t0 = now_seconds();
+        fill_bt(bt, build_keys, build_vals, nkeys, bulk_build, fill);
+        build_sec = now_seconds() - t0;
 
         long total_node_visits = 0;
         long nf = 0;
+        long lookups = 0;
 
-        t0 = now_seconds();
-        for (int64_t q = 0; q < nqueries; q++) {
-            int64_t k;
-            if (!strcmp(workload, "zipf")) {
-                k = zipf_sample(zg);
-            } else {
-                k = rand_uniform(nkeys);
+        if (ys) {
+            elapsed = ycsb_run(ys, bt, NULL, ytally, &nf, &total_node_visits, lat);
+            lookups = ytally[Y_READ].ops + ytally[Y_RMW].ops;
+        } else if (threads > 0) {
+            if (threads > 1) bt_make_concurrent(bt);
+            Worker sum = {0};
+            elapsed = run_streams(streams, threads, bt, NULL, batch, thread_qps, &sum, lat);
+            total_node_visits = sum.node_visits;
+            nf = sum.misses;
+            lookups = sum.lookups;
+            deletes = sum.deletes;
+        } else {
+            OpStream *pre = pregen
+                ? make_streams(1, nqueries, zg, nkeys, sparse, miss_frac, delete_frac, shift_every)
+                : NULL;
+            t0 = now_seconds();
+            for (int64_t q = 0; q < nqueries; q++) {
+                int64_t k;
+                if (shift_every > 0 && q > 0 && q % shift_every == 0)
+                    shift = (shift + nkeys / 3) % nkeys;
+                if (pre ? pre->del[q] : delete_frac > 0.0 && rng_double() < delete_frac) {
+                    nf += run_bt_batch(bt, batch_keys, &nbatch, batch_out, &total_node_visits, lat);
+                    k = pre ? pre->keys[q] : key_of(rand_uniform(nkeys), sparse);
+                    uint64_t ta = lat ? now_ns() : 0;
+                    bt_delete(bt, k);
+                    if (lat) lat_record(lat, LAT_DELETE, now_ns() - ta);
+                    deletes++;
+                    continue;
+                }
+                k = pre ? pre->keys[q] : draw_key(zg, nkeys, shift, sparse, miss_frac);
+                lookups++;
+                if (batch > 1) {
+                    batch_keys[nbatch++] = k;
+                    if (nbatch == (size_t)batch)
+                        nf += run_bt_batch(bt, batch_keys, &nbatch, batch_out, &total_node_visits, lat);
+                    continue;
+                }
+                BTStats s = {0};
+                uint64_t ta = lat ? now_ns() : 0;
+                void *v = bt_search(bt, k, &s);
+                if (lat) lat_record(lat, v ? LAT_COLD : LAT_MISS, now_ns() - ta);
+                total_node_visits += s.node_visits;
+                if (v == NULL)
+                    nf++;
             }
-            BTStats s = {0};
-            void *v = bt_search(bt, k, &s);
-            total_node_visits += s.node_visits;
-            if (v == NULL)
-                nf++;
+            nf += run_bt_batch(bt, batch_keys, &nbatch, batch_out, &total_node_visits, lat);
+            t1 = now_seconds();
+            elapsed = t1 - t0;
+            if (pre) free_streams(pre, 1);
         }
-        t1 = now_seconds();
-
-        elapsed = t1 - t0;
         qps = (elapsed > 0.0) ? (double)nqueries / elapsed : 0.0;
 
         not_found = nf;
-        cold_hits = nqueries - nf;  // everything goes to "cold" conceptually
+        cold_hits = lookups - nf;  // everything goes to "cold" conceptually
         hot_hits = 0;
         hot_keys = 0;
         cold_keys = bt_count_keys(bt);
         avg_hot_nodes_q = 0.0;
-        avg_cold_nodes_q = nqueries ? (double)total_node_visits / (double)nqueries : 0.0;
+        avg_cold_nodes_q = lookups ? (double)total_node_visits / (double)lookups : 0.0;
+        ns_per_node = total_node_visits ? elapsed * 1e9 / (double)total_node_visits : 0.0;
+        olc_restarts = bt_olc_restarts(bt);
+        if (streams) free_streams(streams, threads);
+        thread_summary(thread_qps, threads, qps, ref_qps,
+                       &qps_thread_min, &qps_thread_max, &scaling_eff);
 
         if (!csv) {
             printf("\n=== Results (Baseline) ===\n");
+            printf("Build (sec):      %.6f (%s)\n", build_sec, bulk_build ? "bulk" : "insert");
             printf("Elapsed (sec):    %.6f\n", elapsed);
             printf("Throughput (Q/s): %.2f\n", qps);
+            if (threads > 0)
+                print_threads(thread_qps, threads, ref_qps, scaling_eff, olc_restarts, nqueries);
+            if (ys)
+                print_ycsb(&ycsb, ytally);
             printf("Cold hits:        %ld\n", cold_hits);
             printf("Not found:        %ld\n", not_found);
+            if (deletes)
+                printf("Deletes:          %ld\n", deletes);
             printf("Cold keys:        %zu\n", cold_keys);
             printf("Avg nodes/q:      %.3f\n", avg_cold_nodes_q);
+            if (batch > 1)
+                printf("Batch size:       %" PRId64 "\n", batch);
+            printf("Node layout:      %s\n", bt_node_layout());
+            printf("Search kernel:    %s\n", bt_search_kernel_name(bt_get_search_kernel()));
+            printf("ns / node visit:  %.2f\n", ns_per_node);
         }
 
         bt_free(bt);
     }
 
     if (zg) zipf_free(zg);
+    ycsb_free(ys);
+    free(build_keys);
+    free(build_vals);
+    free(batch_keys);
+    free(batch_out);
+    free(thread_qps);
+    if (lat && !csv) {
+        printf("\n");
+        print_latency(lat);
+    }
 
     if (csv) {
         // Single CSV line. Note: we still print hot_* fields for baseline (they'll be 0).
         const char *mode_str = (mode == MODE_HCTREE) ? "hctree" : "baseline";
         printf("%s,%s,%.5f,%" PRId64 ",%" PRId64 ",%.5f,%.5f,%.5f,%u,"
-               "%.6f,%.2f,%ld,%ld,%ld,%zu,%zu,%.6f,%.6f\n",
+               "%.6f,%.2f,%ld,%ld,%ld,%zu,%zu,%.6f,%.6f,%s,%.3f,%.6f,%ld,"
+               "%s,%ld,%ld,%.6f,%s,%zu,%s,%s,%" PRId64 ",%ld,%zu,%d,%ld,%ld,%d,"
+               "%d,%.2f,%.2f,%ld,%.4f",
                mode_str,
                workload,
                theta,
@@ -325,8 +1601,38 @@ int main(int argc, char **argv) {
                hot_keys,
                cold_keys,
                avg_hot_nodes_q,
-               avg_cold_nodes_q);
+               avg_cold_nodes_q,
+               bt_node_layout(),
+               ns_per_node,
+               build_sec,
+               deletes,
+               mode == MODE_HCTREE ? hc_evict_policy_name(evict) : "none",
+               promotions,
+               demotions,
+               shift_hot_ratio,
+               mode == MODE_HCTREE ? hc_heat_backend_name(heat) : "none",
+               heat_bytes,
+               mode == MODE_HCTREE ? hot_tree_name : "none",
+               bt_variant_name(cold_variant),
+               batch,
+               not_found_filtered,
+               filter_bytes,
+               mode == MODE_HCTREE && async_promote,
+               promote_dropped,
+               hot_bypassed,
+               mode == MODE_HCTREE ? shards : 1,
+               threads > 0 ? threads : 1,
+               qps_thread_min,
+               qps_thread_max,
+               olc_restarts,
+               scaling_eff);
+        print_latency_csv(lat);
+        printf(",%d,%s,%s", pregen || threads > 0, use_ycsb ? ycsb.name : "none",
+               use_ycsb ? ycsb_dist_name[ycsb.dist] : "none");
+        print_ycsb_csv(ytally);
+        printf("\n");
     }
+    lat_free(lat);
 
     return 0;
 }
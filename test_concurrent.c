@@ -0,0 +1,144 @@
+// test_concurrent.c
+// Stress test for HCParams.concurrent: lookup threads that promote on
+// every cold hit race one writer that deletes or updates every key. After
+// each round the index must agree with what the writer did: no deleted
+// key may survive in hot, and no hot copy may keep an old payload. A
+// read-only round checks that racing promotions of one key count once.
+// Run with `make test`; exits non-zero on the first failing round.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "hctree.h"
+
+#define NKEYS    200000
+#define READERS  3
+#define ROUNDS   3
+
+enum { ROUND_READ, ROUND_DELETE, ROUND_UPDATE };
+static const char *const round_name[] = { "read", "delete", "update" };
+
+typedef struct {
+    HCIndex      *idx;
+    _Atomic int  *done;
+    _Atomic long *next;     // read round: shared cursor, else NULL
+    uint64_t      rng;
+} Reader;
+
+static uint64_t next_rand(uint64_t *s) {
+    *s ^= *s << 13;
+    *s ^= *s >> 7;
+    *s ^= *s << 17;
+    return *s;
+}
+
+// Read round: every thread takes the next slot of one shared cursor, and
+// READERS + 1 consecutive slots look up the same key, so threads meet on
+// keys that are still cold.
+static void sweep(HCIndex *idx, _Atomic long *next) {
+    long i;
+    while ((i = atomic_fetch_add(next, 1)) < (long)NKEYS * (READERS + 1))
+        (void)hc_search(idx, (BTKey)(i / (READERS + 1)));
+}
+
+static void* reader_main(void *arg) {
+    Reader *r = (Reader*)arg;
+    if (r->next) {
+        sweep(r->idx, r->next);
+        return NULL;
+    }
+    while (!atomic_load_explicit(r->done, memory_order_relaxed))
+        (void)hc_search(r->idx, (BTKey)(next_rand(&r->rng) % NKEYS));
+    return NULL;
+}
+
+// Payload of key k in generation g; never NULL.
+static BTPayload payload(BTKey k, int g) {
+    return (BTPayload)(intptr_t)(k * 4 + g + 1);
+}
+
+static HCIndex* build(void) {
+    HCParams p = {0};
+    p.decay_alpha      = 0.9;
+    p.hot_threshold    = 1.0;   // every cold hit promotes
+    p.max_hot_fraction = 1.0;
+    p.inclusive        = 1;
+    p.concurrent       = 1;
+    HCIndex *idx = hc_create(NKEYS - 1, 32, p);
+    BTKey     *keys = (BTKey*)malloc(sizeof(BTKey) * NKEYS);
+    BTPayload *vals = (BTPayload*)malloc(sizeof(BTPayload) * NKEYS);
+    for (BTKey k = 0; k < NKEYS; k++) {
+        keys[k] = k;
+        vals[k] = payload(k, 0);
+    }
+    hc_bulk_load(idx, keys, vals, NKEYS, 1.0);
+    free(keys);
+    free(vals);
+    return idx;
+}
+
+// One round: READERS lookup threads against one writer that deletes or
+// updates every key in a shuffled order, or READERS + 1 threads sweeping
+// the keys together. Returns the number of keys whose final state is
+// wrong, plus any miscounted promotions.
+static long run_round(int kind, uint64_t seed) {
+    HCIndex *idx = build();
+    BTKey *order = (BTKey*)malloc(sizeof(BTKey) * NKEYS);
+    for (BTKey k = 0; k < NKEYS; k++) order[k] = k;
+    for (size_t i = NKEYS - 1; i > 0; i--) {
+        size_t j = (size_t)(next_rand(&seed) % (i + 1));
+        BTKey t = order[i]; order[i] = order[j]; order[j] = t;
+    }
+
+    _Atomic int done = 0;
+    _Atomic long next = 0;
+    Reader r[READERS];
+    pthread_t tid[READERS];
+    for (int i = 0; i < READERS; i++) {
+        r[i].idx = idx;
+        r[i].done = &done;
+        r[i].next = kind == ROUND_READ ? &next : NULL;
+        r[i].rng = seed + 0x9e3779b97f4a7c15ULL * (uint64_t)(i + 1);
+        pthread_create(&tid[i], NULL, reader_main, &r[i]);
+    }
+    if (kind == ROUND_READ) sweep(idx, &next);
+    for (size_t i = 0; kind != ROUND_READ && i < NKEYS; i++) {
+        if (kind == ROUND_DELETE) hc_delete(idx, order[i]);
+        else hc_insert(idx, order[i], payload(order[i], 1));
+    }
+    atomic_store(&done, 1);
+    for (int i = 0; i < READERS; i++) pthread_join(tid[i], NULL);
+
+    // Counted before the check below, whose lookups promote too.
+    HCStats s = hc_get_stats(idx);
+    long bad = 0;
+    for (BTKey k = 0; k < NKEYS; k++) {
+        BTPayload want = kind == ROUND_DELETE ? NULL
+                       : payload(k, kind == ROUND_UPDATE);
+        if (hc_search(idx, k) != want) bad++;
+    }
+    if (kind == ROUND_READ && (s.demotions || s.promotions != (long)s.hot_keys))
+        bad += labs(s.promotions - (long)s.hot_keys) + s.demotions;
+    if (kind == ROUND_DELETE) {
+        HCStats e = hc_get_stats(idx);
+        bad += (long)(e.hot_keys + e.cold_keys);
+    }
+    printf("%s round: %ld wrong (promotions %ld, hot_keys %zu, cold_keys %zu)\n",
+           round_name[kind], bad, s.promotions, s.hot_keys, s.cold_keys);
+    free(order);
+    hc_free(idx);
+    return bad;
+}
+
+int main(void) {
+    long bad = 0;
+    for (int round = 0; round < ROUNDS; round++) {
+        bad += run_round(ROUND_READ, 2042 + (uint64_t)round);
+        bad += run_round(ROUND_DELETE, 42 + (uint64_t)round);
+        bad += run_round(ROUND_UPDATE, 1042 + (uint64_t)round);
+    }
+    printf("%s\n", bad ? "FAIL" : "OK");
+    return bad != 0;
+}